@@ -0,0 +1,245 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+extern "C" {
+#include "gemm.h"
+}
+
+#include <chrono>
+#include <csetjmp>
+#include <csignal>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+
+using GemmFunc = void (*)(const float *, const float *, float *, const size_t, const size_t, const size_t);
+
+/**
+ * @brief Input and output buffers of a single GEMM problem filled with random values.
+ */
+struct GemmProblem {
+    size_t n;
+    size_t m;
+    size_t k;
+    std::vector<float> A;
+    std::vector<float> B;
+    std::vector<float> C;
+
+    GemmProblem(size_t n_, size_t m_, size_t k_) : n(n_), m(m_), k(k_), A(n_ * m_), B(m_ * k_), C(n_ * k_, 0.0f) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+        std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    }
+
+    double flops() const { return 2.0 * n * m * k; }
+};
+
+/**
+ * @brief Measures the best time of a call.
+ *
+ * The function is called once for warm up and then repeatedly until at least
+ * min_repeats calls were made and at least min_seconds elapsed in total.
+ *
+ * @return Best time of a single call in seconds.
+ */
+template <typename Func>
+double BenchBestTime(Func &&func, size_t min_repeats = 3, double min_seconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+
+    func();
+
+    double best = 1e30;
+    double total = 0.0;
+    for (size_t rep = 0; rep < min_repeats || total < min_seconds; ++rep) {
+        const auto start = Clock::now();
+        func();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        best = std::min(best, elapsed);
+        total += elapsed;
+    }
+    return best;
+}
+
+/**
+ * @brief Values of the user counters: rdcycle, rdtime and rdinstret on RISC-V.
+ *
+ * Elsewhere cycles are the time stamp counter on x86, time is steady_clock in ns and instret is not available.
+ */
+struct CounterSample {
+    uint64_t cycles;
+    uint64_t time;
+    uint64_t instret;
+};
+
+#if defined(__riscv)
+inline uint64_t ReadCycles() {
+    uint64_t value;
+    asm volatile("rdcycle %0" : "=r"(value));
+    return value;
+}
+
+inline uint64_t ReadTime() {
+    uint64_t value;
+    asm volatile("rdtime %0" : "=r"(value));
+    return value;
+}
+
+inline uint64_t ReadInstret() {
+    uint64_t value;
+    asm volatile("rdinstret %0" : "=r"(value));
+    return value;
+}
+#else
+inline uint64_t ReadCycles() {
+#if defined(__x86_64__)
+    uint32_t low;
+    uint32_t high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return (static_cast<uint64_t>(high) << 32) | low;
+#else
+    return 0;
+#endif
+}
+
+inline uint64_t ReadTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t ReadInstret() {
+    return 0;
+}
+#endif
+
+/**
+ * @brief Counters the process may read.
+ *
+ * Linux may deny user access to cycle and instret (perf_user_access), then reading them raises SIGILL.
+ * Every counter is read once under a SIGILL handler and the ones that trap are not read afterwards.
+ */
+struct CounterAvailability {
+    bool cycles;
+    bool time;
+    bool instret;
+};
+
+namespace detail {
+inline sigjmp_buf &ProbeEnv() {
+    static sigjmp_buf env;
+    return env;
+}
+
+inline bool ProbeCounter(uint64_t (*read)()) {
+    struct sigaction action{};
+    struct sigaction previous{};
+    action.sa_handler = [](int) { siglongjmp(ProbeEnv(), 1); };
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGILL, &action, &previous) != 0) {
+        return false;
+    }
+    volatile bool available = false;
+    if (sigsetjmp(ProbeEnv(), 1) == 0) {
+        (void)read();
+        available = true;
+    }
+    sigaction(SIGILL, &previous, nullptr);
+    return available;
+}
+} // namespace detail
+
+inline const CounterAvailability &AvailableCounters() {
+#if defined(__riscv)
+    static const CounterAvailability available = {
+        detail::ProbeCounter(ReadCycles), detail::ProbeCounter(ReadTime), detail::ProbeCounter(ReadInstret)};
+#elif defined(__x86_64__)
+    static const CounterAvailability available = {true, true, false};
+#else
+    static const CounterAvailability available = {false, true, false};
+#endif
+    return available;
+}
+
+inline CounterSample ReadCounters() {
+    const CounterAvailability &available = AvailableCounters();
+    return {available.cycles ? ReadCycles() : 0, available.time ? ReadTime() : 0,
+            available.instret ? ReadInstret() : 0};
+}
+
+/**
+ * @brief Best values of a call over the repetitions, each minimized separately.
+ *
+ * Counters the process may not read are 0.
+ */
+struct BenchMeasurement {
+    double seconds;
+    uint64_t cycles;
+    uint64_t time;
+    uint64_t instret;
+    size_t iterations; /* Measured calls, without the warm-up one */
+};
+
+/**
+ * @brief Measures the best time and counter deltas of a call.
+ *
+ * The calls are repeated as in BenchBestTime.
+ */
+template <typename Func>
+BenchMeasurement BenchMeasure(Func &&func, size_t min_repeats = 3, double min_seconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+
+    func();
+
+    BenchMeasurement best = {1e30, UINT64_MAX, UINT64_MAX, UINT64_MAX, 0};
+    double total = 0.0;
+    for (size_t rep = 0; rep < min_repeats || total < min_seconds; ++rep) {
+        const auto start = Clock::now();
+        const CounterSample before = ReadCounters();
+        func();
+        const CounterSample after = ReadCounters();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        best.seconds = std::min(best.seconds, elapsed);
+        best.cycles = std::min(best.cycles, after.cycles - before.cycles);
+        best.time = std::min(best.time, after.time - before.time);
+        best.instret = std::min(best.instret, after.instret - before.instret);
+        best.iterations++;
+        total += elapsed;
+    }
+    return best;
+}
+
+/**
+ * @brief Measures the best time of a GEMM call.
+ *
+ * @return Best time of a single call in seconds.
+ */
+inline double BenchGemm(GemmFunc func, GemmProblem &p, size_t min_repeats = 3, double min_seconds = 0.2) {
+    return BenchBestTime([&] { func(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k); }, min_repeats, min_seconds);
+}
+
+inline double Gflops(const GemmProblem &p, double seconds) {
+    return p.flops() / seconds * 1e-9;
+}
+
+/**
+ * @brief Name of the backend as in RMVGEMM_BACKEND and the config files.
+ */
+inline const char *BackendName(gemm_backend_t backend) {
+    switch (backend) {
+    case GEMM_BACKEND_REF:
+        return "ref";
+    case GEMM_BACKEND_RVV:
+        return "rvv";
+    case GEMM_BACKEND_RVM:
+        return "rvm";
+    default:
+        return "auto";
+    }
+}
+
+#endif // BENCH_COMMON_HPP
@@ -0,0 +1,41 @@
+#include "bench_common.hpp"
+
+/**
+ * Batch of small products: separate gemm_block4x4_rvm calls compared with one gemm_strided_batched call.
+ */
+int main() {
+    const size_t sizes[] = {16, 32, 64};
+    const size_t batch = 256;
+
+    std::printf("%8s %8s %14s %14s %10s\n", "size", "batch", "loop GFLOPS", "batch GFLOPS", "speedup");
+    for (const size_t size : sizes) {
+        std::vector<GemmProblem> problems;
+        for (size_t i = 0; i < batch; ++i) {
+            problems.emplace_back(size, size, size);
+        }
+        // One contiguous copy for the strided call
+        std::vector<float> A(size * size * batch);
+        std::vector<float> B(size * size * batch);
+        std::vector<float> C(size * size * batch, 0.0f);
+        for (size_t i = 0; i < batch; ++i) {
+            std::copy(problems[i].A.begin(), problems[i].A.end(), A.begin() + i * size * size);
+            std::copy(problems[i].B.begin(), problems[i].B.end(), B.begin() + i * size * size);
+        }
+
+        const double loop_time = BenchBestTime([&] {
+            for (GemmProblem &p : problems) {
+                gemm_block4x4_rvm(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k);
+            }
+        });
+        const double batch_time = BenchBestTime([&] {
+            gemm_strided_batched(A.data(), size * size, B.data(), size * size, C.data(), size * size,
+                                 size, size, size, batch);
+        });
+
+        const double flops = problems[0].flops() * batch;
+        std::printf("%8zu %8zu %14.3f %14.3f %10.2f\n", size, batch, flops / loop_time * 1e-9,
+                    flops / batch_time * 1e-9, loop_time / batch_time);
+    }
+
+    return 0;
+}
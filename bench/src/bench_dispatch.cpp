@@ -0,0 +1,47 @@
+#include "bench_common.hpp"
+
+extern "C" {
+#include "gemm_thread.h"
+}
+
+static void EmptyTask(void *, const size_t) {}
+
+/**
+ * Latency of waking the thread pool and cost of small parallel GEMMs compared with serial ones.
+ */
+int main() {
+    const size_t threads[] = {1, 2, 4};
+    const size_t sizes[] = {16, 32, 64, 128};
+    const size_t dispatches = 10000;
+    const size_t threshold = gemm_get_parallel_threshold();
+
+    std::printf("%8s %16s\n", "threads", "dispatch, us");
+    for (const size_t count : threads) {
+        gemm_set_num_threads(count);
+        const double time = BenchBestTime([&] {
+            for (size_t i = 0; i < dispatches; ++i) {
+                gemm_parallel_for(count, EmptyTask, nullptr);
+            }
+        });
+        std::printf("%8zu %16.3f\n", count, time / dispatches * 1e6);
+    }
+
+    std::printf("\n%8s %8s %14s %14s\n", "size", "threads", "serial, us", "parallel, us");
+    for (const size_t size : sizes) {
+        GemmProblem p(size, size, size);
+        for (const size_t count : threads) {
+            gemm_set_num_threads(count);
+
+            gemm_set_parallel_threshold(SIZE_MAX);
+            const double serial_time = BenchGemm(gemm_block4x4_rvm, p);
+            gemm_set_parallel_threshold(0);
+            const double parallel_time = BenchGemm(gemm_block4x4_rvm, p);
+
+            std::printf("%8zu %8zu %14.3f %14.3f\n", size, count, serial_time * 1e6, parallel_time * 1e6);
+        }
+    }
+    gemm_set_parallel_threshold(threshold);
+    gemm_set_num_threads(0);
+
+    return 0;
+}
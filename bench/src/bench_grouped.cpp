@@ -0,0 +1,58 @@
+#include "bench_common.hpp"
+
+extern "C" {
+#include "gemm_thread.h"
+}
+
+/**
+ * Mixture-of-experts style group: different number of rows per expert, the same weights shape.
+ * Separate gemm_block4x4_rvm calls compared with one gemm_grouped call.
+ */
+int main() {
+    const size_t rows[] = {3, 17, 250, 40, 1, 96, 512, 8};
+    const size_t m = 256;
+    const size_t k = 256;
+    const size_t threads[] = {1, 2, 4};
+
+    std::vector<GemmProblem> experts;
+    std::vector<gemm_problem_t> problems;
+    double flops = 0.0;
+    for (const size_t n : rows) {
+        experts.emplace_back(n, m, k);
+    }
+    for (GemmProblem &p : experts) {
+        problems.push_back({p.n, p.m, p.k, p.A.data(), p.B.data(), p.C.data()});
+        flops += p.flops();
+    }
+
+    std::printf("%8s %14s %14s %10s %10s\n", "threads", "loop GFLOPS", "group GFLOPS", "speedup", "imbalance");
+    for (const size_t count : threads) {
+        gemm_set_num_threads(count);
+
+        const double loop_time = BenchBestTime([&] {
+            for (GemmProblem &p : experts) {
+                gemm_block4x4_rvm(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k);
+            }
+        });
+        const double group_time = BenchBestTime([&] { gemm_grouped(problems.data(), problems.size()); });
+
+        double imbalance = 0.0;
+        if (count > 1) {
+            gemm_parallel_stats_t stats;
+            gemm_parallel_get_stats(&stats);
+            double max_busy = 0.0;
+            double sum_busy = 0.0;
+            for (size_t t = 0; t < stats.threads; ++t) {
+                max_busy = std::max(max_busy, stats.busy[t]);
+                sum_busy += stats.busy[t];
+            }
+            imbalance = (sum_busy > 0.0) ? (max_busy * stats.threads / sum_busy) - 1.0 : 0.0;
+        }
+
+        std::printf("%8zu %14.3f %14.3f %10.2f %10.3f\n", count, flops / loop_time * 1e-9, flops / group_time * 1e-9,
+                    loop_time / group_time, imbalance);
+    }
+    gemm_set_num_threads(0);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "bench_common.hpp"
+
+extern "C" {
+#include "gemm_kernel.h"
+}
+
+/**
+ * Cost of packing A and B blocks into micro-panels compared with the whole GEMM.
+ *
+ * For an n x m x k GEMM the driver packs every MC x KC block of A once per NC-wide column block
+ * and every KC x NC block of B once, the packing share below is estimated from these counts.
+ */
+int main() {
+    const size_t size = 512;
+    const gemm_blocking_t &blocking = gemm_default_blocking;
+    const gemm_kernel_t *kernels[] = {&gemm_kernel_ref, &gemm_kernel_rvv, &gemm_kernel_rvm};
+
+    GemmProblem p(size, size, size);
+
+    std::printf("n = m = k = %zu, MC = %zu, KC = %zu, NC = %zu\n", size, blocking.mc, blocking.kc, blocking.nc);
+    std::printf("%8s %14s %14s %14s %14s\n", "kernel", "pack A GB/s", "pack B GB/s", "GEMM GFLOPS", "packing %");
+    for (const gemm_kernel_t *kernel : kernels) {
+        std::vector<float> Ap(gemm_pack_a_size(kernel, blocking.mc, blocking.kc));
+        std::vector<float> Bp(gemm_pack_b_size(kernel, blocking.kc, blocking.nc));
+
+        const double pack_a_time = BenchBestTime([&] {
+            gemm_pack_a_block(kernel, blocking.mc, blocking.kc, 1.0f, p.A.data(), p.m, 1, Ap.data());
+        });
+        const double pack_b_time = BenchBestTime([&] {
+            gemm_pack_b_block(kernel, blocking.kc, blocking.nc, p.B.data(), p.k, 1, Bp.data());
+        });
+        const double gemm_time = BenchBestTime([&] {
+            gemm_driver(kernel, &blocking, p.A.data(), p.m, p.B.data(), p.k, p.C.data(), p.k, p.n, p.m, p.k);
+        });
+
+        const double a_blocks = std::ceil(double(p.n) / blocking.mc) * std::ceil(double(p.m) / blocking.kc) *
+                                std::ceil(double(p.k) / blocking.nc);
+        const double b_blocks = std::ceil(double(p.m) / blocking.kc) * std::ceil(double(p.k) / blocking.nc);
+        const double pack_share = (a_blocks * pack_a_time + b_blocks * pack_b_time) / gemm_time;
+
+        const double a_bytes = double(blocking.mc * blocking.kc * sizeof(float));
+        const double b_bytes = double(blocking.kc * blocking.nc * sizeof(float));
+        std::printf("%8s %14.3f %14.3f %14.3f %14.1f\n", kernel->name,
+                    a_bytes / pack_a_time * 1e-9, b_bytes / pack_b_time * 1e-9,
+                    Gflops(p, gemm_time), pack_share * 100.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+#include "bench_common.hpp"
+
+/**
+ * Throughput of the THEAD matrix extension kernel compared with the scalar 4x4 blocked kernel.
+ */
+int main() {
+    const size_t sizes[] = {16, 32, 64, 128, 256, 512};
+
+    std::printf("%8s %14s %14s %10s\n", "size", "ref GFLOPS", "rvm GFLOPS", "speedup");
+    for (const size_t size : sizes) {
+        GemmProblem p(size, size, size);
+
+        const double ref_time = BenchGemm(gemm_block4x4_ref, p);
+        const double rvm_time = BenchGemm(gemm_block4x4_rvm, p);
+
+        std::printf("%8zu %14.3f %14.3f %10.2f\n", size, Gflops(p, ref_time), Gflops(p, rvm_time), ref_time / rvm_time);
+    }
+
+    return 0;
+}
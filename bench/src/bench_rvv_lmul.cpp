@@ -0,0 +1,46 @@
+#include "bench_common.hpp"
+
+/**
+ * Throughput of the RVV kernel for every register grouping depending on the number of columns k.
+ */
+int main() {
+    const size_t n = 64;
+    const size_t m = 64;
+    const size_t widths[] = {4, 16, 64, 128, 256, 512, 1024, 2048};
+
+    const struct {
+        const char *name;
+        GemmFunc func;
+    } variants[] = {
+        {"m1", gemm_block4x4_rvv_m1},
+        {"m2", gemm_block4x4_rvv_m2},
+        {"m4", gemm_block4x4_rvv_m4},
+        {"m8", gemm_block4x4_rvv_m8},
+    };
+
+    std::printf("GFLOPS for n = %zu, m = %zu\n", n, m);
+    std::printf("%8s", "k");
+    for (const auto &variant : variants) {
+        std::printf(" %10s", variant.name);
+    }
+    std::printf(" %8s\n", "best");
+
+    for (const size_t k : widths) {
+        GemmProblem p(n, m, k);
+
+        std::printf("%8zu", k);
+        const char *best_name = "";
+        double best_gflops = 0.0;
+        for (const auto &variant : variants) {
+            const double gflops = Gflops(p, BenchGemm(variant.func, p));
+            if (gflops > best_gflops) {
+                best_gflops = gflops;
+                best_name = variant.name;
+            }
+            std::printf(" %10.3f", gflops);
+        }
+        std::printf(" %8s\n", best_name);
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "bench_common.hpp"
+
+#include <cstdlib>
+
+/**
+ * Crossover of gemm_strassen: the time of the Strassen-Winograd product with different crossovers compared
+ * with gemm_block4x4_rvm, the kernel at its leaves. The best crossover is the value for GEMM_STRASSEN_CROSSOVER.
+ * Sizes of the square products are taken from the arguments, 1024 and 2048 by default.
+ */
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {1024, 2048};
+    }
+    const size_t crossovers[] = {64, 128, 256, 512, 1024};
+
+    std::printf("%8s %10s %10s %14s %10s %12s\n", "size", "crossover", "levels", "GFLOPS", "speedup", "workspace MB");
+    for (const size_t size : sizes) {
+        GemmProblem p(size, size, size);
+        const double rvm_time = BenchGemm(gemm_block4x4_rvm, p);
+        std::printf("%8zu %10s %10s %14.3f %10.2f %12s\n", size, "rvm", "-", Gflops(p, rvm_time), 1.0, "-");
+
+        size_t best_crossover = 0;
+        double best_time = rvm_time;
+        for (const size_t crossover : crossovers) {
+            if (crossover >= size) {
+                continue;
+            }
+            size_t levels = 0;
+            for (size_t leaf = size; leaf > crossover; leaf = (leaf / 8) * 4) {
+                levels++;
+            }
+
+            const size_t bytes = gemm_strassen_workspace_size(p.n, p.m, p.k, crossover);
+            std::vector<float> workspace(bytes / sizeof(float));
+            const double time = BenchBestTime([&] {
+                gemm_strassen(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k, crossover, workspace.data());
+            });
+            if (time < best_time) {
+                best_time = time;
+                best_crossover = crossover;
+            }
+            std::printf("%8zu %10zu %10zu %14.3f %10.2f %12.1f\n", size, crossover, levels, Gflops(p, time),
+                        rvm_time / time, double(bytes) / (1 << 20));
+        }
+
+        if (best_crossover != 0) {
+            std::printf("%8zu best crossover %zu, %.2fx of rvm\n", size, best_crossover, rvm_time / best_time);
+        } else {
+            std::printf("%8zu no crossover is faster than rvm\n", size);
+        }
+    }
+
+    return 0;
+}
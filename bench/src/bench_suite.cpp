@@ -0,0 +1,226 @@
+#include "bench_common.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+
+/**
+ * Kernel under benchmark. Kernels of a backend the hart does not run (or the target is not built for) are skipped.
+ */
+struct Kernel {
+    const char *name;
+    gemm_backend_t backend;
+    size_t max_work; /* Larger shapes are skipped, 0 for no bound */
+    std::function<void(GemmProblem &)> run;
+};
+
+/**
+ * Shape of a benchmark, the category names the kind of product (square, rectangular, tall-skinny, tiny).
+ */
+struct Shape {
+    const char *category;
+    size_t n;
+    size_t m;
+    size_t k;
+};
+
+/**
+ * Result of one kernel on one shape.
+ */
+struct Result {
+    std::string name;
+    const char *kernel;
+    const Shape *shape;
+    BenchMeasurement measurement;
+    double gflops;
+    double bytes;
+};
+
+template <GemmFunc func>
+static Kernel MakeKernel(const char *name, gemm_backend_t backend, size_t max_work = 0) {
+    return {name, backend, max_work, [](GemmProblem &p) { func(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k); }};
+}
+
+static std::vector<Kernel> Kernels() {
+    return {
+        // The naive triple loop is slow enough to dominate the run on large shapes
+        MakeKernel<gemm_ref>("gemm_ref", GEMM_BACKEND_REF, 256 * 256 * 256),
+        MakeKernel<gemm_block4x4_ref>("gemm_block4x4_ref", GEMM_BACKEND_REF),
+        MakeKernel<gemm_block4x4_rvv>("gemm_block4x4_rvv", GEMM_BACKEND_RVV),
+        MakeKernel<gemm_block4x4_rvv_m1>("gemm_block4x4_rvv_m1", GEMM_BACKEND_RVV),
+        MakeKernel<gemm_block4x4_rvv_m2>("gemm_block4x4_rvv_m2", GEMM_BACKEND_RVV),
+        MakeKernel<gemm_block4x4_rvv_m4>("gemm_block4x4_rvv_m4", GEMM_BACKEND_RVV),
+        MakeKernel<gemm_block4x4_rvv_m8>("gemm_block4x4_rvv_m8", GEMM_BACKEND_RVV),
+        MakeKernel<gemm_block4x4_rvm>("gemm_block4x4_rvm", GEMM_BACKEND_RVM),
+        MakeKernel<gemm>("gemm", GEMM_BACKEND_REF),
+        {"sgemm", GEMM_BACKEND_REF, 0, [](GemmProblem &p) {
+            sgemm(GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, p.n, p.k, p.m, 1.0f,
+                  p.A.data(), p.m, p.B.data(), p.k, 1.0f, p.C.data(), p.k);
+        }},
+        {"gemm_block4x4_rvm_epilogue", GEMM_BACKEND_RVM, 0, [](GemmProblem &p) {
+            gemm_epilogue_t epilogue{};
+            epilogue.alpha = 1.0f;
+            epilogue.beta = 1.0f;
+            epilogue.activation = GEMM_ACTIVATION_RELU;
+            gemm_block4x4_rvm_epilogue(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k, &epilogue);
+        }},
+    };
+}
+
+static const Shape shapes[] = {
+    {"tiny", 4, 4, 4},
+    {"tiny", 8, 8, 8},
+    {"tiny", 16, 16, 16},
+    {"square", 64, 64, 64},
+    {"square", 256, 256, 256},
+    {"square", 512, 512, 512},
+    {"rectangular", 128, 512, 256},
+    {"rectangular", 384, 64, 192},
+    {"tall-skinny", 4096, 64, 16},
+    {"tall-skinny", 16, 1024, 1024},
+};
+
+/**
+ * Compulsory traffic of a call: A and B are read once, C is read and written once.
+ */
+static double BytesMoved(const Shape &shape) {
+    return sizeof(float) * ((shape.n * shape.m) + (shape.m * shape.k) + (2.0 * shape.n * shape.k));
+}
+
+/**
+ * Counter per FLOP as a JSON value, null if the counter is not available.
+ */
+static std::string PerFlop(bool available, uint64_t value, const Shape &shape) {
+    if (!available) {
+        return "null";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.4f", value / (2.0 * shape.n * shape.m * shape.k));
+    return text;
+}
+
+/**
+ * Counters which count the work of a call. rdcycle and rdinstret count the calling hart only, with more threads
+ * they miss the work of the pool and include the calling thread waiting for it, which depends on the scheduling.
+ */
+static CounterAvailability CallCounters() {
+    CounterAvailability counters = AvailableCounters();
+    if (gemm_get_num_threads() > 1) {
+        counters.cycles = false;
+        counters.instret = false;
+    }
+    return counters;
+}
+
+static void WriteJson(std::FILE *file, const std::vector<Result> &results) {
+    const CounterAvailability counters = CallCounters();
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"num_threads\": %zu,\n", gemm_get_num_threads());
+    std::fprintf(file, "    \"backend\": \"%s\",\n", BackendName(gemm_get_backend()));
+    std::fprintf(file, "    \"counters\": {\"cycles\": %s, \"time\": %s, \"instret\": %s}\n",
+                 counters.cycles ? "true" : "false", counters.time ? "true" : "false",
+                 counters.instret ? "true" : "false");
+    std::fprintf(file, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        const BenchMeasurement &b = r.measurement;
+        std::fprintf(file,
+                     "    {\"name\": \"%s\", \"kernel\": \"%s\", \"category\": \"%s\", "
+                     "\"n\": %zu, \"m\": %zu, \"k\": %zu, \"iterations\": %zu, "
+                     "\"real_time\": %.1f, \"time_unit\": \"ns\", \"gflops\": %.4f, "
+                     "\"bytes\": %.0f, \"bytes_per_second\": %.0f, "
+                     "\"cycles\": %llu, \"time_ticks\": %llu, \"instructions\": %llu, "
+                     "\"cycles_per_flop\": %s, \"instructions_per_flop\": %s}%s\n",
+                     r.name.c_str(), r.kernel, r.shape->category, r.shape->n, r.shape->m, r.shape->k, b.iterations,
+                     b.seconds * 1e9, r.gflops, r.bytes, r.bytes / b.seconds,
+                     static_cast<unsigned long long>(b.cycles), static_cast<unsigned long long>(b.time),
+                     static_cast<unsigned long long>(b.instret),
+                     PerFlop(counters.cycles, b.cycles, *r.shape).c_str(),
+                     PerFlop(counters.instret, b.instret, *r.shape).c_str(), (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+}
+
+/**
+ * Runs every kernel of gemm.h over tiny, square, rectangular and tall-skinny shapes and prints the best time,
+ * GFLOPS, compulsory bytes, cycles and retired instructions per FLOP of a call (rdcycle and rdinstret on RISC-V,
+ * null if the counter is not available). The kernels run on one thread unless --threads is given, cycles and
+ * instructions are then null, as the counters of the calling hart do not cover the pool:
+ *   bench_suite [--filter=<substring of the name>] [--json=<path>] [--threads=<count>]
+ * Benchmarks are named <kernel>/<n>/<m>/<k>, the JSON output follows the layout of Google Benchmark.
+ */
+int main(int argc, char **argv) {
+    const char *filter = nullptr;
+    const char *json = nullptr;
+    size_t threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            json = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::strtoul(argv[i] + 10, nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--filter=<substring>] [--json=<path>] [--threads=<count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Probe the backends the hart runs, kernels of the others are skipped
+    const gemm_backend_t selected = gemm_get_backend();
+    bool supported[GEMM_BACKEND_RVM + 1];
+    for (const gemm_backend_t backend : {GEMM_BACKEND_REF, GEMM_BACKEND_RVV, GEMM_BACKEND_RVM}) {
+        supported[backend] = gemm_set_backend(backend) == 0;
+    }
+    gemm_set_backend(selected);
+
+    // 0 restores the default number of threads
+    gemm_set_num_threads(threads);
+
+    std::vector<Result> results;
+    const CounterAvailability counters = CallCounters();
+    std::printf("%-44s %12s %10s %10s %12s %10s %12s %12s\n",
+                "benchmark", "time, us", "iters", "GFLOPS", "bytes", "GB/s", "cycles/FLOP", "instr/FLOP");
+    for (const Kernel &kernel : Kernels()) {
+        if (!supported[kernel.backend]) {
+            std::printf("%-44s skipped: backend is not available\n", kernel.name);
+            continue;
+        }
+        for (const Shape &shape : shapes) {
+            const std::string name = std::string(kernel.name) + "/" + std::to_string(shape.n) + "/"
+                                   + std::to_string(shape.m) + "/" + std::to_string(shape.k);
+            const size_t work = shape.n * shape.m * shape.k;
+            if (((filter != nullptr) && (name.find(filter) == std::string::npos))
+                || ((kernel.max_work != 0) && (work > kernel.max_work))) {
+                continue;
+            }
+
+            GemmProblem p(shape.n, shape.m, shape.k);
+            const BenchMeasurement b = BenchMeasure([&] { kernel.run(p); }, 3, 0.1);
+            const Result result = {name, kernel.name, &shape, b, Gflops(p, b.seconds), BytesMoved(shape)};
+            results.push_back(result);
+
+            std::printf("%-44s %12.3f %10zu %10.3f %12.0f %10.3f %12s %12s\n", name.c_str(), b.seconds * 1e6,
+                        b.iterations, result.gflops, result.bytes, result.bytes / b.seconds * 1e-9,
+                        PerFlop(counters.cycles, b.cycles, shape).c_str(),
+                        PerFlop(counters.instret, b.instret, shape).c_str());
+        }
+    }
+
+    if (json != nullptr) {
+        std::FILE *file = std::fopen(json, "w");
+        if (file == nullptr) {
+            std::fprintf(stderr, "Cannot write %s\n", json);
+            return 1;
+        }
+        WriteJson(file, results);
+        std::fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "bench_common.hpp"
+
+extern "C" {
+#include "gemm_thread.h"
+}
+
+/**
+ * Load imbalance of the last parallel loop: the latest time a thread ran out of tasks (from the start of the loop,
+ * so a late wake-up counts) over the mean one, minus 1.
+ * 0 means all threads finished at the same time.
+ */
+static double LastImbalance() {
+    gemm_parallel_stats_t stats;
+    gemm_parallel_get_stats(&stats);
+
+    double max_busy = 0.0;
+    double sum_busy = 0.0;
+    for (size_t t = 0; t < stats.threads; ++t) {
+        max_busy = std::max(max_busy, stats.busy[t]);
+        sum_busy += stats.busy[t];
+    }
+    return (sum_busy > 0.0) ? (max_busy * stats.threads / sum_busy) - 1.0 : 0.0;
+}
+
+static size_t LastStolen() {
+    gemm_parallel_stats_t stats;
+    gemm_parallel_get_stats(&stats);
+
+    size_t stolen = 0;
+    for (size_t t = 0; t < stats.threads; ++t) {
+        stolen += stats.stolen[t];
+    }
+    return stolen;
+}
+
+/**
+ * Scaling of the blocked kernels with the number of threads and load imbalance between threads.
+ */
+int main() {
+    const size_t shapes[][3] = {
+        {256, 256, 256},
+        {512, 512, 512},
+        {1024, 1024, 1024},
+        // Tall and wide shapes
+        {2048, 64, 2048},
+        // 7x5x1 edge case scaled up: partial tiles in every direction
+        {707, 505, 101},
+    };
+    const size_t threads[] = {1, 2, 4};
+    const struct {
+        const char *name;
+        GemmFunc func;
+    } kernels[] = {
+        {"rvv", gemm_block4x4_rvv},
+        {"rvm", gemm_block4x4_rvm},
+    };
+
+    std::printf("%8s %16s %8s %14s %10s %10s %8s\n", "kernel", "n x m x k", "threads", "GFLOPS", "speedup", "imbalance", "stolen");
+    for (const auto &kernel : kernels) {
+        for (const auto &shape : shapes) {
+            GemmProblem p(shape[0], shape[1], shape[2]);
+            const std::string name = std::to_string(p.n) + "x" + std::to_string(p.m) + "x" + std::to_string(p.k);
+
+            double serial_time = 0.0;
+            for (const size_t count : threads) {
+                gemm_set_num_threads(count);
+                const double time = BenchGemm(kernel.func, p);
+                if (count == 1) {
+                    serial_time = time;
+                    std::printf("%8s %16s %8zu %14.3f %10.2f %10s %8s\n", kernel.name, name.c_str(), count,
+                                Gflops(p, time), 1.0, "-", "-");
+                } else {
+                    std::printf("%8s %16s %8zu %14.3f %10.2f %10.3f %8zu\n", kernel.name, name.c_str(), count,
+                                Gflops(p, time), serial_time / time, LastImbalance(), LastStolen());
+                }
+            }
+        }
+    }
+    gemm_set_num_threads(0);
+
+    return 0;
+}
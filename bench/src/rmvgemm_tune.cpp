@@ -0,0 +1,233 @@
+#include "bench_common.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+/**
+ * Class of shapes tuned together: the emitted rule matches shapes up to the bounds,
+ * the parameters are measured on the representative shape.
+ */
+struct ShapeClass {
+    const char *name;
+    size_t max_n;
+    size_t max_m;
+    size_t max_k;
+    size_t n;
+    size_t m;
+    size_t k;
+};
+
+/**
+ * Frequency of the cycle counter, measured once against steady_clock.
+ */
+static double CyclesPerSecond() {
+    static const double frequency = [] {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const uint64_t cycles = ReadCycles();
+        while (Clock::now() - start < std::chrono::milliseconds(100)) {
+        }
+        return (ReadCycles() - cycles) / std::chrono::duration<double>(Clock::now() - start).count();
+    }();
+    return frequency;
+}
+
+/**
+ * Time of gemm on the problem with a single rule in the dispatch table. Candidates are ranked by cycles
+ * where the cycle counter is readable, the cycles are converted to seconds with the measured frequency
+ * so that the printed GFLOPS and times stay comparable.
+ */
+static double BenchRule(const gemm_rule_t &rule, GemmProblem &p) {
+    gemm_set_rules(&rule, 1);
+    const BenchMeasurement b = BenchMeasure([&] { gemm(p.A.data(), p.B.data(), p.C.data(), p.n, p.m, p.k); }, 3, 0.05);
+    if (!AvailableCounters().cycles) {
+        return b.seconds;
+    }
+    return b.cycles / CyclesPerSecond();
+}
+
+static gemm_rule_t MakeRule(gemm_strategy_t strategy) {
+    gemm_rule_t rule{};
+    rule.strategy = strategy;
+    rule.backend = GEMM_BACKEND_AUTO;
+    return rule;
+}
+
+/**
+ * Largest work of the square sizes up to which the unpacked loops beat the serial blocked driver, 0 if they never do.
+ */
+static size_t TuneUnpacked() {
+    const size_t sizes[] = {4, 8, 12, 16, 24, 32, 48};
+    size_t max_work = 0;
+
+    std::printf("%-10s %8s %14s %14s\n", "unpacked", "size", "unpacked, us", "blocked, us");
+    for (const size_t size : sizes) {
+        GemmProblem p(size, size, size);
+        gemm_rule_t blocked = MakeRule(GEMM_STRATEGY_BLOCKED);
+        blocked.threads = 1;
+        const double unpacked_time = BenchRule(MakeRule(GEMM_STRATEGY_UNPACKED), p);
+        const double blocked_time = BenchRule(blocked, p);
+        std::printf("%-10s %8zu %14.3f %14.3f\n", "", size, unpacked_time * 1e6, blocked_time * 1e6);
+        if (unpacked_time >= blocked_time) {
+            break;
+        }
+        max_work = size * size * size;
+    }
+    return max_work;
+}
+
+/**
+ * Checks that the gemv strategy beats the blocked driver on products with `rows` rows (or columns when transposed).
+ */
+static bool TuneGemv(const size_t rows, const bool columns) {
+    const size_t size = 512;
+    GemmProblem p(columns ? size : rows, size, columns ? rows : size);
+    const double gemv_time = BenchRule(MakeRule(GEMM_STRATEGY_GEMV), p);
+    const double blocked_time = BenchRule(MakeRule(GEMM_STRATEGY_BLOCKED), p);
+    std::printf("%-10s %8zu %8zu %8zu %14.3f %14.3f\n", "gemv", p.n, p.m, p.k, gemv_time * 1e6, blocked_time * 1e6);
+    return gemv_time < blocked_time;
+}
+
+/**
+ * Finds the backend, panel sizes and thread count of the blocked driver for a shape class:
+ * the backend is chosen with the default panels, then the panels on all threads, then the threads.
+ * The recursive driver with the same backend and threads replaces the result if it is faster.
+ */
+static gemm_rule_t TuneBlocked(const ShapeClass &shape) {
+    GemmProblem p(shape.n, shape.m, shape.k);
+    gemm_rule_t best = MakeRule(GEMM_STRATEGY_BLOCKED);
+    double best_time = BenchRule(best, p);
+
+    const gemm_backend_t selected = gemm_get_backend();
+    for (const gemm_backend_t backend : {GEMM_BACKEND_REF, GEMM_BACKEND_RVV, GEMM_BACKEND_RVM}) {
+        if (gemm_set_backend(backend) != 0) {
+            continue;
+        }
+        gemm_rule_t rule = best;
+        rule.backend = backend;
+        const double time = BenchRule(rule, p);
+        if (time < best_time) {
+            best = rule;
+            best_time = time;
+        }
+    }
+    gemm_set_backend(selected);
+
+    for (const size_t mc : {32, 64, 128}) {
+        for (const size_t kc : {128, 256, 512}) {
+            for (const size_t nc : {256, 512, 1024}) {
+                gemm_rule_t rule = best;
+                rule.mc = mc;
+                rule.kc = kc;
+                rule.nc = nc;
+                const double time = BenchRule(rule, p);
+                if (time < best_time) {
+                    best = rule;
+                    best_time = time;
+                }
+            }
+        }
+    }
+
+    for (size_t threads = 1; threads < gemm_get_num_threads(); threads *= 2) {
+        gemm_rule_t rule = best;
+        rule.threads = threads;
+        const double time = BenchRule(rule, p);
+        if (time < best_time) {
+            best = rule;
+            best_time = time;
+        }
+    }
+
+    gemm_rule_t recursive = MakeRule(GEMM_STRATEGY_RECURSIVE);
+    recursive.backend = best.backend;
+    recursive.threads = best.threads;
+    const double recursive_time = BenchRule(recursive, p);
+    std::printf("%-10s %8zu %8zu %8zu %8s %6zu %6zu %6zu %8zu %10.3f %10.3f\n", shape.name, shape.n, shape.m, shape.k,
+                BackendName(best.backend), best.mc, best.kc, best.nc, best.threads, Gflops(p, best_time),
+                Gflops(p, recursive_time));
+    if (recursive_time < best_time) {
+        best = recursive;
+    }
+
+    best.max_n = shape.max_n;
+    best.max_m = shape.max_m;
+    best.max_k = shape.max_k;
+    return best;
+}
+
+static void WriteRule(std::FILE *file, const char *strategy, const gemm_rule_t &rule) {
+    std::fprintf(file, "%s", strategy);
+    const struct {
+        const char *key;
+        size_t value;
+    } fields[] = {
+        {"max_n", rule.max_n}, {"max_m", rule.max_m}, {"max_k", rule.max_k}, {"max_work", rule.max_work},
+        {"mc", rule.mc}, {"kc", rule.kc}, {"nc", rule.nc}, {"threads", rule.threads},
+    };
+    for (const auto &field : fields) {
+        if (field.value != 0) {
+            std::fprintf(file, " %s=%zu", field.key, field.value);
+        }
+    }
+    if (rule.backend != GEMM_BACKEND_AUTO) {
+        std::fprintf(file, " backend=%s", BackendName(rule.backend));
+    }
+    std::fprintf(file, "\n");
+}
+
+/**
+ * Sweeps the dispatch parameters over a set of shapes and writes the measured rules as a config file
+ * for RMVGEMM_CONFIG (rmvgemm.conf by default):
+ *   rmvgemm_tune [path]
+ */
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "rmvgemm.conf";
+    const ShapeClass shapes[] = {
+        {"small", 128, 128, 128, 96, 96, 96},
+        {"medium", 512, 512, 512, 256, 256, 256},
+        {"large", 0, 0, 0, 768, 768, 768},
+    };
+
+    const size_t unpacked_work = TuneUnpacked();
+    std::printf("\n%-10s %8s %8s %8s %14s %14s\n", "gemv", "n", "m", "k", "gemv, us", "blocked, us");
+    const bool gemv_rows = TuneGemv(2, false);
+    const bool gemv_columns = TuneGemv(2, true);
+
+    std::printf("\n%-10s %8s %8s %8s %8s %6s %6s %6s %8s %10s %10s\n",
+                "blocked", "n", "m", "k", "backend", "mc", "kc", "nc", "threads", "GFLOPS", "recursive");
+    std::vector<gemm_rule_t> blocked;
+    for (const ShapeClass &shape : shapes) {
+        blocked.push_back(TuneBlocked(shape));
+    }
+    gemm_set_rules(nullptr, 0);
+
+    std::FILE *file = std::fopen(path, "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Cannot write %s: %s\n", path, std::strerror(errno));
+        return 1;
+    }
+    std::fprintf(file, "# Generated by rmvgemm_tune on %zu threads\n", gemm_get_num_threads());
+    if (unpacked_work != 0) {
+        gemm_rule_t rule = MakeRule(GEMM_STRATEGY_UNPACKED);
+        rule.max_work = unpacked_work;
+        WriteRule(file, "unpacked", rule);
+    }
+    if (gemv_rows) {
+        gemm_rule_t rule = MakeRule(GEMM_STRATEGY_GEMV);
+        rule.max_n = 2;
+        WriteRule(file, "gemv", rule);
+    }
+    if (gemv_columns) {
+        gemm_rule_t rule = MakeRule(GEMM_STRATEGY_GEMV);
+        rule.max_k = 2;
+        WriteRule(file, "gemv", rule);
+    }
+    for (const gemm_rule_t &rule : blocked) {
+        WriteRule(file, (rule.strategy == GEMM_STRATEGY_RECURSIVE) ? "recursive" : "blocked", rule);
+    }
+    std::fclose(file);
+
+    std::printf("\nWrote %s\n", path);
+    return 0;
+}
@@ -23,6 +23,11 @@ elseif("${TARGET_ARCH}" STREQUAL "RV64GV")
 elseif("${TARGET_ARCH}" STREQUAL "RV64GVM")
     target_compile_options(BaseConfiguration INTERFACE -march=rv64gcv0p7_xtheadmatrix)
     target_compile_definitions(BaseConfiguration INTERFACE -DRV64GVM)
+elseif("${TARGET_ARCH}" STREQUAL "RV64_DISPATCH")
+    # One library for all harts: the common code is built for rv64gc, the vector and matrix kernels
+    # with their own -march (lib/CMakeLists.txt), and the best kernel is selected at runtime.
+    target_compile_options(BaseConfiguration INTERFACE -march=rv64gc)
+    target_compile_definitions(BaseConfiguration INTERFACE -DRV64G)
 elseif("${TARGET_ARCH}" STREQUAL "X86")
     target_compile_definitions(BaseConfiguration INTERFACE -DX86)
 else()
@@ -47,3 +52,17 @@ endif()
 # Used for all files except custom configuration in lib/CMakeLists.txt and benchmarks
 add_library(CommonConfiguration INTERFACE)
 target_link_libraries(CommonConfiguration INTERFACE BaseConfiguration BaseOptConfiguration)
+
+# Configurations of the kernels in the RV64_DISPATCH build.
+# The same flags as CommonConfiguration with the instruction set of the kernel instead of rv64gc.
+function(add_kernel_configuration NAME MARCH DEFINITION)
+    add_library(${NAME} INTERFACE)
+    target_compile_options(${NAME} INTERFACE -Wall -Wextra -march=${MARCH})
+    target_compile_definitions(${NAME} INTERFACE ${DEFINITION})
+    target_link_libraries(${NAME} INTERFACE BaseOptConfiguration)
+endfunction()
+
+if("${TARGET_ARCH}" STREQUAL "RV64_DISPATCH")
+    add_kernel_configuration(RvvKernelConfiguration rv64gcv0p7 -DRV64GV)
+    add_kernel_configuration(RvmKernelConfiguration rv64gcv0p7_xtheadmatrix -DRV64GVM)
+endif()
@@ -6,8 +6,12 @@
 #include <assert.h>
 #include <stdio.h>
 
-#include <riscv_matrix.h>
+#if defined(RV64GV) || defined(RV64GVM)
 #include <riscv_vector.h>
+#endif
+#ifdef RV64GVM
+#include <riscv_matrix.h>
+#endif
 
 /**
  * Multiplies two matrices.
@@ -48,6 +52,22 @@ extern void gemm_block4x4_ref(const float *A, const float *B, float *C, const si
  */
 extern void gemm_block4x4_rvv(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
 
+/**
+ * Variants of gemm_block4x4_rvv with fixed register grouping (LMUL = 1, 2, 4, 8).
+ * gemm_block4x4_rvv calls the one selected with RVV_LMUL at build time.
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param B Pointer to the second matrix (size m x k).
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ */
+extern void gemm_block4x4_rvv_m1(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
+extern void gemm_block4x4_rvv_m2(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
+extern void gemm_block4x4_rvv_m4(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
+extern void gemm_block4x4_rvv_m8(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
+
 /**
  * Multiplies two matrices A and B with dimensions n x m and m x k respectively
  * using a block-based approach and THEAD RISC-V matrix extension.
@@ -61,10 +81,566 @@ extern void gemm_block4x4_rvv(const float *A, const float *B, float *C, const si
  */
 extern void gemm_block4x4_rvm(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
 
+//
+// Runtime dispatch
+//
+
+/**
+ * Kernel family used by gemm and the other entry points without a kernel in their name.
+ */
+typedef enum gemm_backend {
+    GEMM_BACKEND_AUTO = -1, /* Backend selected for the hart, only in gemm_rule_t */
+    GEMM_BACKEND_REF = 0, /* Scalar kernel, runs on any hart */
+    GEMM_BACKEND_RVV, /* RISC-V Vector extension 0.7.1 */
+    GEMM_BACKEND_RVM, /* THEAD RISC-V matrix extension */
+} gemm_backend_t;
+
+#define GEMM_BACKEND_COUNT 3
+
+/**
+ * Multiplies two matrices A and B with dimensions n x m and m x k respectively
+ * with the fastest kernel the hart supports: C += A * B.
+ * The extensions are probed on the first call, the RMVGEMM_BACKEND environment variable
+ * (ref, rvv or rvm) overrides the choice if the hart supports it.
+ * The strategy, blocking and thread count come from the first rule matching the shape (see gemm_rule_t).
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param B Pointer to the second matrix (size m x k).
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ */
+extern void gemm(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k);
+
+/**
+ * Backend selected for this hart.
+ */
+extern gemm_backend_t gemm_get_backend(void);
+
+/**
+ * Selects the backend used by gemm, sgemm, the batched functions and pre-packed B.
+ *
+ * @param backend Backend to use.
+ * @return 0 on success, -1 if the backend is not built for this target or the hart does not support it
+ *         (the selection is not changed).
+ */
+extern int gemm_set_backend(const gemm_backend_t backend);
+
+//
+// Shape-aware dispatch
+//
+
+/**
+ * Maximum number of rules in the dispatch table.
+ */
+#define GEMM_MAX_RULES 32
+
+/**
+ * How gemm computes a product.
+ */
+typedef enum gemm_strategy {
+    GEMM_STRATEGY_UNPACKED = 0, /* Loops over A, B and C in place on the calling thread, for tiny products */
+    GEMM_STRATEGY_GEMV, /* Loops over A, B and C in place, rows or columns split between threads, for skinny products */
+    GEMM_STRATEGY_BLOCKED, /* Packing blocked driver */
+    GEMM_STRATEGY_RECURSIVE, /* Cache-oblivious driver halving the largest dimension, needs no panel sizes */
+} gemm_strategy_t;
+
+/**
+ * Rule of the dispatch table. The rule matches a product if every non-zero bound holds,
+ * gemm uses the first matching rule, products no rule matches use GEMM_STRATEGY_BLOCKED with the defaults.
+ */
+typedef struct gemm_rule {
+    size_t max_n; /* Bound of the rows of A and C */
+    size_t max_m; /* Bound of the inner dimension */
+    size_t max_k; /* Bound of the columns of B and C */
+    size_t max_work; /* Bound of n * m * k */
+    gemm_strategy_t strategy;
+    gemm_backend_t backend; /* Kernel of the rule (the row kernel for GEMM_STRATEGY_UNPACKED and GEMM_STRATEGY_GEMV), falls back to the selected backend if not supported */
+    size_t mc; /* Panel sizes of GEMM_STRATEGY_BLOCKED, 0 for the defaults */
+    size_t kc;
+    size_t nc;
+    size_t threads; /* Upper bound of the threads, 0 for gemm_get_num_threads() */
+} gemm_rule_t;
+
+/**
+ * Replaces the dispatch table.
+ *
+ * @param rules Rules in the order they are checked, NULL restores the table gemm starts with
+ *              (RMVGEMM_CONFIG file if set, the built-in table otherwise).
+ * @param count Number of rules.
+ * @return 0 on success, -1 if count exceeds GEMM_MAX_RULES, a rule has an unknown strategy or backend
+ *         or out of memory (the table is not changed).
+ */
+extern int gemm_set_rules(const gemm_rule_t *rules, const size_t count);
+
+/**
+ * Replaces the dispatch table with the rules of a config file, see README.md for the format.
+ * gemm loads the file named by the RMVGEMM_CONFIG environment variable on the first call.
+ *
+ * @param path Path to the config file.
+ * @return 0 on success, -1 if the file cannot be read, has an invalid line or out of memory
+ *         (the table is not changed).
+ */
+extern int gemm_load_rules(const char *path);
+
+/**
+ * Rule gemm uses for a product of the given shape.
+ *
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ */
+extern gemm_rule_t gemm_get_rule(const size_t n, const size_t m, const size_t k);
+
+//
+// Batched GEMM
+//
+
+/**
+ * Multiplies batch pairs of matrices A[i] and B[i] with dimensions n x m and m x k respectively
+ * using the selected backend (see gemm): C[i] += A[i] * B[i].
+ * Small products are distributed between threads as a whole and share the per-call setup.
+ *
+ * @param A Array of pointers to the first matrices (size n x m).
+ * @param B Array of pointers to the second matrices (size m x k).
+ * @param C Array of pointers to the resulting matrices (size n x k).
+ * @param n Number of rows in matrices A and resulting matrices C.
+ * @param m Number of columns in matrices A and number of rows in matrices B.
+ * @param k Number of columns in matrices B and resulting matrices C.
+ * @param batch Number of products.
+ */
+extern void gemm_batched(const float *const *A, const float *const *B, float *const *C,
+                         const size_t n, const size_t m, const size_t k, const size_t batch);
+
+/**
+ * Multiplies batch pairs of matrices placed at fixed distances from each other
+ * using the selected backend: C + i * strideC += (A + i * strideA) * (B + i * strideB).
+ *
+ * @param A Pointer to the first of the first matrices (size n x m).
+ * @param strideA Distance between the first matrices in elements.
+ * @param B Pointer to the first of the second matrices (size m x k).
+ * @param strideB Distance between the second matrices in elements, 0 to use the same B for all products.
+ * @param C Pointer to the first of the resulting matrices (size n x k).
+ * @param strideC Distance between the resulting matrices in elements.
+ * @param n Number of rows in matrices A and resulting matrices C.
+ * @param m Number of columns in matrices A and number of rows in matrices B.
+ * @param k Number of columns in matrices B and resulting matrices C.
+ * @param batch Number of products.
+ */
+extern void gemm_strided_batched(const float *A, const size_t strideA, const float *B, const size_t strideB,
+                                 float *C, const size_t strideC,
+                                 const size_t n, const size_t m, const size_t k, const size_t batch);
+
+/**
+ * One product of grouped GEMM: C += A * B, all matrices are row-major.
+ */
+typedef struct gemm_problem {
+    size_t n; /* Rows of A and C */
+    size_t m; /* Columns of A and rows of B */
+    size_t k; /* Columns of B and C */
+    const float *A;
+    const float *B;
+    float *C;
+} gemm_problem_t;
+
+/**
+ * Multiplies groups of matrices of different shapes using the selected backend:
+ * problems[i].C += problems[i].A * problems[i].B.
+ * Macro-tiles of all problems are scheduled on the thread pool together.
+ *
+ * @param problems Array of problem descriptors.
+ * @param count Number of problems.
+ */
+extern void gemm_grouped(const gemm_problem_t *problems, const size_t count);
+
+//
+// BLAS-compatible interface
+//
+
+/**
+ * Storage order of the matrices in sgemm (values match CBLAS_ORDER).
+ */
+typedef enum gemm_layout {
+    GEMM_ROW_MAJOR = 101,
+    GEMM_COL_MAJOR = 102,
+} gemm_layout_t;
+
+/**
+ * Operation applied to a matrix in sgemm (values match CBLAS_TRANSPOSE).
+ */
+typedef enum gemm_transpose {
+    GEMM_NO_TRANS = 111,
+    GEMM_TRANS = 112,
+} gemm_transpose_t;
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C, where op(X) is X or its transpose.
+ * Transposes are handled while the matrices are packed. beta = 0 overwrites C without reading it.
+ *
+ * @param layout Storage order of all matrices.
+ * @param transA Operation applied to A.
+ * @param transB Operation applied to B.
+ * @param M Number of rows in op(A) and C.
+ * @param N Number of columns in op(B) and C.
+ * @param K Number of columns in op(A) and rows in op(B).
+ * @param alpha Factor of the product.
+ * @param A Pointer to matrix A.
+ * @param lda Leading dimension of A.
+ * @param B Pointer to matrix B.
+ * @param ldb Leading dimension of B.
+ * @param beta Factor of C.
+ * @param C Pointer to matrix C (size M x N).
+ * @param ldc Leading dimension of C.
+ * @return 0 on success, otherwise the number of the first invalid parameter as reported by xerbla in the reference
+ *         BLAS: 1 (layout), 2 (transA), 3 (transB), 9 (lda), 11 (ldb) or 14 (ldc); nothing is computed then.
+ *         A leading dimension must be at least 1 and at least the number of elements in a stored row
+ *         (row-major) or column (column-major) of the matrix.
+ */
+extern int sgemm(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                 const size_t M, const size_t N, const size_t K, const float alpha,
+                 const float *A, const size_t lda, const float *B, const size_t ldb,
+                 const float beta, float *C, const size_t ldc);
+
+/**
+ * sgemm with the scalar, RISC-V Vector and THEAD matrix extension kernels.
+ * sgemm uses the selected backend (see gemm).
+ */
+extern int sgemm_ref(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc);
+extern int sgemm_rvv(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc);
+extern int sgemm_rvm(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc);
+
+//
+// Fused epilogue
+//
+
+/**
+ * Activation applied to the elements of C by the fused epilogue.
+ */
+typedef enum gemm_activation {
+    GEMM_ACTIVATION_NONE = 0,
+    GEMM_ACTIVATION_RELU, /* max(x, 0) */
+    GEMM_ACTIVATION_GELU, /* 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))) */
+} gemm_activation_t;
+
+/**
+ * Operations fused into the multiplication:
+ *   C[i][j] = act(alpha * (A * B)[i][j] + beta * C[i][j] + col_bias[j] + row_bias[i]).
+ * Biases and the activation are applied to the last rank update of every micro tile
+ * before it is stored, so C is written once instead of being read again by a separate pass.
+ */
+typedef struct gemm_epilogue {
+    float alpha; /* Factor of the product */
+    float beta; /* Factor of C, 0 overwrites C without reading it */
+    const float *row_bias; /* n elements added to the rows of C, may be NULL */
+    const float *col_bias; /* k elements added to the columns of C, may be NULL */
+    gemm_activation_t activation;
+} gemm_epilogue_t;
+
+/**
+ * Multiplies two matrices A and B with dimensions n x m and m x k respectively
+ * and applies the epilogue to the result, using THEAD RISC-V matrix extension.
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param B Pointer to the second matrix (size m x k).
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ * @param epilogue Operations applied to the result, NULL computes C += A * B.
+ */
+extern void gemm_block4x4_rvm_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue);
+
+/**
+ * gemm_block4x4_rvm_epilogue with the scalar and RISC-V Vector extension kernels.
+ */
+extern void gemm_block4x4_ref_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue);
+extern void gemm_block4x4_rvv_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue);
+
+//
+// Performance counters
+//
+
+/**
+ * Prints the hardware events of the gemm entry points (gemm, gemm_block4x4_*, sgemm*, batched, grouped
+ * and pre-packed calls) per entry point and shape, accumulated since the start or gemm_perf_reset:
+ * time, cycles and IPC per call, cache and dTLB misses per thousand FLOPs and the share of backend stall cycles.
+ * The events are counted with perf_event_open on the calling thread and on the pool workers while they run the tasks
+ * of the call, and summed per call; counts of multiplexed counters are scaled by the time they were counting.
+ * Without perf_event_open (no PMU driver, perf_event_paranoid, QEMU user mode) only rdcycle cycles or the time
+ * are reported.
+ * Batched calls are recorded with the shape of their products, grouped calls with a 0 x 0 x 0 shape;
+ * the misses per FLOP cover the work of all products.
+ * Counting is built only with ENABLE_PERF_COUNTERS=ON, it costs two counter reads and a lock per call.
+ *
+ * @param stream Output stream.
+ * @return 0 on success, -1 if the library is built without the counters.
+ */
+extern int gemm_perf_dump(FILE *stream);
+
+/**
+ * Statistics of an entry point and shape, see gemm_perf_dump.
+ */
+typedef struct gemm_perf_entry {
+    const char *entry; /* Name of the entry point, e.g. "gemm_block4x4_rvm" */
+    size_t n; /* Shape of the products, 0 x 0 x 0 for grouped calls */
+    size_t m;
+    size_t k;
+    uint64_t calls;
+    uint64_t flops; /* Work of all products of the calls */
+    uint64_t time_ns;
+} gemm_perf_entry_t;
+
+/**
+ * Statistics gemm_perf_dump prints, in no particular order.
+ *
+ * @param entries Output array.
+ * @param capacity Size of the output array.
+ * @return Number of entry point and shape pairs, it may exceed capacity; 0 if the library is built without the counters.
+ */
+extern size_t gemm_perf_get_stats(gemm_perf_entry_t *entries, const size_t capacity);
+
+/**
+ * Clears the statistics of gemm_perf_dump.
+ */
+extern void gemm_perf_reset(void);
+
+//
+// Tracing
+//
+
+/**
+ * Call of an entry point passed to the trace callback.
+ */
+typedef struct gemm_trace_event {
+    const char *entry; /* Name of the entry point, e.g. "gemm_block4x4_rvm" */
+    gemm_backend_t backend; /* Backend which ran the call: the one of the entry point, of the rule for gemm (ref for
+                               unpacked loops without a vector row kernel), the selected one for sgemm, batched and grouped */
+    size_t n; /* Shape of the products, 0 x 0 x 0 for grouped calls */
+    size_t m;
+    size_t k;
+    size_t batch; /* Products of the call: the batch size, the problems of a grouped call, 1 otherwise */
+    uint64_t flops; /* Work of all products of the call */
+    uint64_t time_ns; /* Duration of the call */
+} gemm_trace_event_t;
+
+typedef void (*gemm_trace_callback_t)(const gemm_trace_event_t *event, void *user);
+
+/**
+ * Totals of the traced calls per backend.
+ */
+typedef struct gemm_trace_stats {
+    uint64_t calls[GEMM_BACKEND_COUNT]; /* Calls of the entry points */
+    uint64_t flops[GEMM_BACKEND_COUNT]; /* Work of all products of the calls */
+    uint64_t time_ns[GEMM_BACKEND_COUNT];
+    uint64_t untracked; /* Products of shapes that did not fit the histogram of their thread */
+} gemm_trace_stats_t;
+
+/**
+ * Entry of the shape histogram.
+ */
+typedef struct gemm_trace_shape {
+    size_t n;
+    size_t m;
+    size_t k;
+    uint64_t calls; /* Products of the shape, a batched call counts each of its products */
+    uint64_t flops;
+    uint64_t time_ns;
+} gemm_trace_shape_t;
+
+/**
+ * Starts or stops counting the calls of the entry points (see gemm_perf_dump for the list).
+ * Every thread counts into its own counters without locks, readers sum them up.
+ * With tracing off (the default) an entry point costs one load and a branch more.
+ * The histogram counts the products of batched calls with their shape and every problem of a grouped call
+ * separately, with the time of the call split between the problems in proportion to their FLOPs.
+ *
+ * @param enable Non-zero to count.
+ */
+extern void gemm_trace_enable(const int enable);
+
+/**
+ * Sets the function called after every entry point call, from the thread that made it.
+ *
+ * @param callback Callback, NULL to remove it.
+ * @param user Argument passed to the callback.
+ */
+extern void gemm_trace_set_callback(gemm_trace_callback_t callback, void *user);
+
+/**
+ * Totals of the calls counted since gemm_trace_enable or gemm_trace_reset.
+ */
+extern void gemm_trace_get_stats(gemm_trace_stats_t *stats);
+
+/**
+ * Shape histogram of the counted calls, the shapes with the largest total time first.
+ *
+ * @param shapes Output array.
+ * @param capacity Size of the output array.
+ * @return Number of distinct shapes, it may exceed capacity.
+ */
+extern size_t gemm_trace_get_shapes(gemm_trace_shape_t *shapes, const size_t capacity);
+
+/**
+ * Clears the counters.
+ */
+extern void gemm_trace_reset(void);
+
+//
+// Threads
+//
+
+/**
+ * Sets the number of threads used by the blocked GEMM functions.
+ * The default is taken from the RMVGEMM_NUM_THREADS environment variable or the number of online harts.
+ *
+ * @param count Number of threads, 0 restores the default.
+ */
+extern void gemm_set_num_threads(const size_t count);
+
+/**
+ * Number of threads used by the blocked GEMM functions.
+ */
+extern size_t gemm_get_num_threads(void);
+
+/**
+ * Sets the smallest problem which is split between threads, smaller ones run on the calling thread
+ * as waking the workers would cost more than the multiplication itself.
+ *
+ * @param threshold Number of multiply-adds (n * m * k), 0 makes every problem parallel.
+ */
+extern void gemm_set_parallel_threshold(const size_t threshold);
+
+/**
+ * Smallest problem (n * m * k multiply-adds) which is split between threads.
+ */
+extern size_t gemm_get_parallel_threshold(void);
+
+//
+// Pre-packed B
+//
+
+/**
+ * Matrix B packed once into the micro-panels of the selected backend (see gemm).
+ * Reusing it skips packing of B when many matrices are multiplied by the same B.
+ */
+typedef struct gemm_packed_b gemm_packed_b;
+
+/**
+ * Size in bytes of a buffer for gemm_pack_b_to.
+ *
+ * @param m Number of rows in matrix B.
+ * @param k Number of columns in matrix B.
+ */
+extern size_t gemm_packed_b_size(const size_t m, const size_t k);
+
+/**
+ * Packs matrix B into a buffer provided by the caller.
+ * The buffer must stay alive while the handle is used, gemm_packed_b_free does not release it.
+ *
+ * @param B Pointer to the matrix (size m x k).
+ * @param m Number of rows in matrix B.
+ * @param k Number of columns in matrix B.
+ * @param buffer Buffer of at least gemm_packed_b_size(m, k) bytes with any alignment.
+ * @return Handle placed in the buffer, NULL if buffer is NULL.
+ */
+extern gemm_packed_b *gemm_pack_b_to(const float *B, const size_t m, const size_t k, void *buffer);
+
+/**
+ * Packs matrix B into a newly allocated buffer.
+ *
+ * @param B Pointer to the matrix (size m x k).
+ * @param m Number of rows in matrix B.
+ * @param k Number of columns in matrix B.
+ * @return Handle to release with gemm_packed_b_free, NULL if out of memory.
+ */
+extern gemm_packed_b *gemm_pack_b(const float *B, const size_t m, const size_t k);
+
+/**
+ * Releases a handle returned by gemm_pack_b. Does nothing for NULL and handles from gemm_pack_b_to.
+ */
+extern void gemm_packed_b_free(gemm_packed_b *packed);
+
+/**
+ * Multiplies matrix A with dimensions n x m by pre-packed matrix B with dimensions m x k
+ * using the kernel B was packed for.
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param packedB Matrix B packed with gemm_pack_b or gemm_pack_b_to.
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ */
+extern void gemm_rvm_prepacked(const float *A, const gemm_packed_b *packedB, float *C, const size_t n);
+
+//
+// Strassen-Winograd
+//
+
+/**
+ * Default crossover of gemm_strassen, products with any dimension not above it are computed by the kernel
+ * of gemm_block4x4_rvm. Tuned with bench_strassen.
+ */
+#define GEMM_STRASSEN_CROSSOVER 512
+
+/**
+ * Size in bytes of the workspace of gemm_strassen.
+ *
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ * @param crossover Crossover passed to gemm_strassen.
+ * @return Size in bytes, 0 if the product is not split.
+ */
+extern size_t gemm_strassen_workspace_size(const size_t n, const size_t m, const size_t k, const size_t crossover);
+
+/**
+ * Multiplies matrix A with dimensions n x m by matrix B with dimensions m x k with the Strassen-Winograd
+ * algorithm: every level splits the matrices into quadrants and replaces 8 products of them by 7 and
+ * 15 additions, down to the crossover where gemm_block4x4_rvm takes over. Odd rows and columns of a level
+ * are multiplied directly.
+ *
+ * The result is not componentwise accurate as the one of gemm_block4x4_rvm (|C - C'| <= m u |A| |B|).
+ * With n0 the size of the products at the crossover, N the largest dimension and u = 2^-24 the error is
+ * bounded in the max norm (Higham, Accuracy and Stability of Numerical Algorithms, 2nd ed., Theorem 23.3):
+ *   max |C - C'| <= ((N / n0)^log2(18) (n0^2 + 6 n0) - 6 N) u max |A| max |B| + O(u^2)
+ * so every level below the crossover increases the bound about 4.5 times. The function is opt-in and not
+ * used by gemm or the dispatch.
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param B Pointer to the second matrix (size m x k).
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ * @param crossover Dimension not split further, 0 for GEMM_STRASSEN_CROSSOVER, values below 8 are raised to 8.
+ * @param workspace Buffer of at least gemm_strassen_workspace_size(n, m, k, crossover) bytes aligned to float,
+ *                  NULL to allocate it for the call.
+ * @return 0 on success, -1 if the workspace could not be allocated, C is not changed then.
+ */
+extern int gemm_strassen(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k,
+                         const size_t crossover, void *workspace);
+
 //
 // Utils functions
 //
 void print_matrix(float* A, size_t n, size_t m);
+#ifdef RV64GVM
 void print_matrix_reg(const char *fmt, const mfloat32_t reg, const size_t n, const size_t m);
+#endif
 
 #endif // GEMM_H
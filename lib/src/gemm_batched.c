@@ -0,0 +1,132 @@
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+// Problems described on the stack at once, larger batches are processed in parts.
+#define BATCH_CHUNK 128
+
+/**
+ * Fills the operands of C += A * B for a row-major problem.
+ */
+static void set_args(gemm_args_t *args, const float *A, const float *B, float *C,
+                     const size_t n, const size_t m, const size_t k)
+{
+    args->n = n;
+    args->m = m;
+    args->k = k;
+    args->alpha = 1.0f;
+    args->A = A;
+    args->rs_a = m;
+    args->cs_a = 1;
+    args->B = B;
+    args->rs_b = k;
+    args->cs_b = 1;
+    args->B_packed = NULL;
+    args->beta = 1.0f;
+    args->C = C;
+    args->ldc = k;
+    args->row_bias = NULL;
+    args->col_bias = NULL;
+    args->activation = GEMM_ACTIVATION_NONE;
+}
+
+/**
+ * Multiplies batch pairs of matrices A[i] and B[i] with dimensions n x m and m x k respectively
+ * using the selected backend (see gemm): C[i] += A[i] * B[i].
+ *
+ * @param A Array of pointers to the first matrices (size n x m).
+ * @param B Array of pointers to the second matrices (size m x k).
+ * @param C Array of pointers to the resulting matrices (size n x k).
+ * @param n Number of rows in matrices A and resulting matrices C.
+ * @param m Number of columns in matrices A and number of rows in matrices B.
+ * @param k Number of columns in matrices B and resulting matrices C.
+ * @param batch Number of products.
+ */
+extern void gemm_batched(const float *const *A, const float *const *B, float *const *C,
+                         const size_t n, const size_t m, const size_t k, const size_t batch)
+{
+    GEMM_TRACE_BEGIN_BATCH(GEMM_BACKEND_AUTO, n, m, k, batch);
+    gemm_args_t args[BATCH_CHUNK];
+
+    for (size_t first = 0; first < batch; first += BATCH_CHUNK) {
+        const size_t count = MIN(BATCH_CHUNK, batch - first);
+        for (size_t i = 0; i < count; i++) {
+            set_args(&args[i], A[first + i], B[first + i], C[first + i], n, m, k);
+        }
+        gemm_driver_batch(gemm_dispatch_kernel(), NULL, args, count);
+    }
+    GEMM_TRACE_END();
+}
+
+/**
+ * Multiplies batch pairs of matrices placed at fixed distances from each other
+ * using the selected backend: C + i * strideC += (A + i * strideA) * (B + i * strideB).
+ *
+ * @param A Pointer to the first of the first matrices (size n x m).
+ * @param strideA Distance between the first matrices in elements.
+ * @param B Pointer to the first of the second matrices (size m x k).
+ * @param strideB Distance between the second matrices in elements, 0 to use the same B for all products.
+ * @param C Pointer to the first of the resulting matrices (size n x k).
+ * @param strideC Distance between the resulting matrices in elements.
+ * @param n Number of rows in matrices A and resulting matrices C.
+ * @param m Number of columns in matrices A and number of rows in matrices B.
+ * @param k Number of columns in matrices B and resulting matrices C.
+ * @param batch Number of products.
+ */
+extern void gemm_strided_batched(const float *A, const size_t strideA, const float *B, const size_t strideB,
+                                 float *C, const size_t strideC,
+                                 const size_t n, const size_t m, const size_t k, const size_t batch)
+{
+    GEMM_TRACE_BEGIN_BATCH(GEMM_BACKEND_AUTO, n, m, k, batch);
+    gemm_args_t args[BATCH_CHUNK];
+
+    // A B shared by all products is packed once for the whole batch. If that fails, every product packs it.
+    gemm_packed_b *shared = ((strideB == 0) && (batch > 1)) ? gemm_pack_b(B, m, k) : NULL;
+    const gemm_kernel_t *kernel = (shared != NULL) ? shared->kernel : gemm_dispatch_kernel();
+    const gemm_blocking_t *blocking = (shared != NULL) ? &shared->blocking : NULL;
+
+    for (size_t first = 0; first < batch; first += BATCH_CHUNK) {
+        const size_t count = MIN(BATCH_CHUNK, batch - first);
+        for (size_t i = 0; i < count; i++) {
+            const size_t index = first + i;
+            set_args(&args[i], &A[index * strideA], &B[index * strideB], &C[index * strideC], n, m, k);
+            args[i].B_packed = (shared != NULL) ? shared->data : NULL;
+        }
+        gemm_driver_batch(kernel, blocking, args, count);
+    }
+
+    gemm_packed_b_free(shared);
+    GEMM_TRACE_END();
+}
+
+/**
+ * Multiplies groups of matrices of different shapes using the selected backend:
+ * problems[i].C += problems[i].A * problems[i].B.
+ *
+ * @param problems Array of problem descriptors.
+ * @param count Number of problems.
+ */
+extern void gemm_grouped(const gemm_problem_t *problems, const size_t count)
+{
+    GEMM_TRACE_BEGIN_GROUPED(GEMM_BACKEND_AUTO, problems, count);
+    gemm_args_t *args = (gemm_args_t *)malloc(count * sizeof(gemm_args_t));
+    if (args == NULL) {
+        // Out of memory: run the problems one by one.
+        gemm_args_t single;
+        for (size_t i = 0; i < count; i++) {
+            const gemm_problem_t *p = &problems[i];
+            set_args(&single, p->A, p->B, p->C, p->n, p->m, p->k);
+            gemm_driver_args(gemm_dispatch_kernel(), NULL, &single);
+        }
+        GEMM_TRACE_END();
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const gemm_problem_t *p = &problems[i];
+        set_args(&args[i], p->A, p->B, p->C, p->n, p->m, p->k);
+    }
+    gemm_driver_grouped(gemm_dispatch_kernel(), NULL, args, count);
+
+    free(args);
+    GEMM_TRACE_END();
+}
@@ -1,8 +1,16 @@
-#include "gemm.h"
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
 
-#define BLOCK_SIZE 4
-
-static inline void process_block_4x4(const size_t k, const float *A, const size_t lda, const float *B, const size_t ldb, float *C, const size_t ldc);
+const gemm_kernel_t gemm_kernel_ref = {
+    .name = "ref",
+    .mr = GEMM_REF_MR,
+    .nr = GEMM_REF_NR,
+    .kr = 1,
+    .setup = NULL,
+    .micro_kernel = gemm_micro_kernel_ref,
+    .probe = NULL,
+    .row_kernel = NULL,
+};
 
 /**
  * Multiplies two matrices A and B with dimensions n x m and m x k respectively
@@ -17,19 +25,58 @@ static inline void process_block_4x4(const size_t k, const float *A, const size_
  */
 extern void gemm_block4x4_ref(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
 {
-    for (size_t j = 0; j < k; j += BLOCK_SIZE) { /* Loop over the columns of C */
-        for (size_t i = 0; i < n; i += BLOCK_SIZE) { /* Loop over the rows of C */
-            process_block_4x4(m, &A[i*m], m, &B[j], k, &C[(i*k) + j], k);
-        }
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_REF, n, m, k);
+    gemm_driver(&gemm_kernel_ref, NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C, see sgemm.
+ */
+extern int sgemm_ref(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc)
+{
+    const int info = gemm_sgemm_check(layout, transA, transB, M, N, K, lda, ldb, ldc);
+    if (info != 0) {
+        return info;
     }
+
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_REF, M, K, N);
+    gemm_sgemm(&gemm_kernel_ref, layout, transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    GEMM_TRACE_END();
+    return 0;
 }
 
-static inline void process_block_4x4(const size_t k, const float *A, const size_t lda, const float *B, const size_t ldb, float *C, const size_t ldc) {
-    for (size_t i = 0; i < BLOCK_SIZE; i += 1) {
-        for (size_t j = 0; j < BLOCK_SIZE; j += 1) {
-            for (size_t p = 0; p < k; p += 1) {
-                C[(j * ldc) + i] += A[(j * lda) + p] * B[(p * ldb) + i];
+/**
+ * Computes C = act(alpha * A * B + beta * C + col_bias + row_bias), see gemm_block4x4_rvm_epilogue.
+ */
+extern void gemm_block4x4_ref_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_REF, n, m, k);
+    gemm_driver_epilogue(&gemm_kernel_ref, A, B, C, n, m, k, epilogue);
+    GEMM_TRACE_END();
+}
+
+/**
+ * Computes C(mr x nr) += Ap * Bp for a 4x4 tile.
+ * Products are added to C in the same order as in gemm_ref, so the results are bitwise equal.
+ */
+extern void gemm_micro_kernel_ref(const size_t kc, const float *Ap, const float *Bp,
+                                  float *C, const size_t ldc, const size_t mr, const size_t nr,
+                                  const gemm_tile_epilogue_t *epilogue)
+{
+    for (size_t i = 0; i < mr; i += 1) {
+        for (size_t j = 0; j < nr; j += 1) {
+            for (size_t p = 0; p < kc; p += 1) {
+                C[(i * ldc) + j] += Ap[(p * GEMM_REF_MR) + i] * Bp[(p * GEMM_REF_NR) + j];
             }
         }
     }
+    if (epilogue != NULL) {
+        gemm_epilogue_store(epilogue, mr, nr, C, ldc, C, ldc);
+    }
 }
@@ -1,7 +1,72 @@
-#include "gemm.h"
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+#include <string.h>
 
 #define BLOCK_SIZE 4
 
+/*
+ * Shape of the register block (in 4x4 tiles) computed by the inner loop:
+ *   RVM_TILE_2X2 - 8x8 block of C, every A and B tile is used twice;
+ *   RVM_TILE_1X4 - 4x16 block of C, every A tile is used four times.
+ * Can be set from the build with -DRVM_TILE_SHAPE=RVM_TILE_1X4.
+ */
+#define RVM_TILE_2X2 1
+#define RVM_TILE_1X4 2
+
+#ifndef RVM_TILE_SHAPE
+#define RVM_TILE_SHAPE RVM_TILE_2X2
+#endif
+
+#if RVM_TILE_SHAPE == RVM_TILE_2X2
+#define RVM_MR (2 * BLOCK_SIZE)
+#define RVM_NR (2 * BLOCK_SIZE)
+#elif RVM_TILE_SHAPE == RVM_TILE_1X4
+#define RVM_MR BLOCK_SIZE
+#define RVM_NR (4 * BLOCK_SIZE)
+#else
+#error "Unsupported RVM_TILE_SHAPE"
+#endif
+
+// Distance in bytes between rows of a 4x4 tile in packed micro-panels.
+#define TILE_STRIDE (BLOCK_SIZE * sizeof(float))
+
+#ifdef RV64GVM
+static inline void process_block_4x4(const size_t k, const float *Ap, const size_t ap_step, const float *Bp, const size_t bp_step, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue);
+static inline void process_block_edge(const size_t k, const size_t mr, const size_t nr, const float *Ap, const size_t ap_step, const float *Bp, const size_t bp_step, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue);
+static inline void process_block_mrxnr(const size_t k, const float *Ap, const float *Bp, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue);
+static inline void store_tile(float *C, const size_t ldc, const mfloat32_t c, const size_t mr, const size_t nr, const gemm_tile_epilogue_t *epilogue);
+static void rvm_setup(void);
+static int rvm_probe(void);
+static void rvm_micro_kernel(const size_t kc, const float *Ap, const float *Bp,
+                             float *C, const size_t ldc, const size_t mr, const size_t nr,
+                             const gemm_tile_epilogue_t *epilogue);
+
+// fmmacc multiplies ms1 by the transposed ms2, so both micro-panels are packed
+// as 4x4 tiles along K (kr = 4): the B tiles hold columns of B as rows.
+const gemm_kernel_t gemm_kernel_rvm = {
+    .name = "rvm",
+    .mr = RVM_MR,
+    .nr = RVM_NR,
+    .kr = BLOCK_SIZE,
+    .setup = rvm_setup,
+    .micro_kernel = rvm_micro_kernel,
+    .probe = rvm_probe,
+    .row_kernel = gemm_row_kernel_rvv,
+};
+#else
+const gemm_kernel_t gemm_kernel_rvm = {
+    .name = "rvm",
+    .mr = GEMM_REF_MR,
+    .nr = GEMM_REF_NR,
+    .kr = 1,
+    .setup = NULL,
+    .micro_kernel = gemm_micro_kernel_ref,
+    .probe = NULL,
+    .row_kernel = NULL,
+};
+#endif // RV64GVM
+
 /**
  * Multiplies two matrices A and B with dimensions n x m and m x k respectively
  * using a block-based approach and THEAD RISC-V matrix extension.
@@ -15,6 +80,233 @@
  */
 extern void gemm_block4x4_rvm(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
 {
-    // TODO: Implement Gemm using THEAD RISC-V matrix extension.
-    gemm_ref(A, B, C, n, m, k);    
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVM, n, m, k);
+    gemm_driver(&gemm_kernel_rvm, NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C using THEAD RISC-V matrix extension, see sgemm.
+ */
+extern int sgemm_rvm(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc)
+{
+    const int info = gemm_sgemm_check(layout, transA, transB, M, N, K, lda, ldb, ldc);
+    if (info != 0) {
+        return info;
+    }
+
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVM, M, K, N);
+    gemm_sgemm(&gemm_kernel_rvm, layout, transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    GEMM_TRACE_END();
+    return 0;
+}
+
+/**
+ * Multiplies two matrices A and B with dimensions n x m and m x k respectively
+ * and applies the epilogue to the result, using THEAD RISC-V matrix extension.
+ *
+ * @param A Pointer to the first matrix (size n x m).
+ * @param B Pointer to the second matrix (size m x k).
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ * @param epilogue Operations applied to the result, NULL computes C += A * B.
+ */
+extern void gemm_block4x4_rvm_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVM, n, m, k);
+    gemm_driver_epilogue(&gemm_kernel_rvm, A, B, C, n, m, k, epilogue);
+    GEMM_TRACE_END();
+}
+
+#ifdef RV64GVM
+/**
+ * Configures the matrix registers for full 4x4 float tiles.
+ */
+static void rvm_setup(void) {
+    mcfgm(BLOCK_SIZE);
+    mcfgn(BLOCK_SIZE);
+    mcfgk(BLOCK_SIZE * sizeof(float));
+}
+
+/**
+ * Checks that the hart runs the kernel: configuring the matrix registers raises SIGILL
+ * without the matrix extension, and the epilogue uses the vector unit with a row of a tile in one register.
+ */
+static int rvm_probe(void) {
+    mcfgm(BLOCK_SIZE);
+    return gemm_probe_rvv_0p7() && (vsetvl_e32m1(BLOCK_SIZE) == BLOCK_SIZE);
+}
+
+/**
+ * Computes C(mr x nr) += Ap * Bp. Full micro tiles use the register-blocked kernel,
+ * partial ones are split into 4x4 tiles.
+ */
+static void rvm_micro_kernel(const size_t kc, const float *Ap, const float *Bp,
+                             float *C, const size_t ldc, const size_t mr, const size_t nr,
+                             const gemm_tile_epilogue_t *epilogue)
+{
+    if ((mr == RVM_MR) && (nr == RVM_NR)) {
+        process_block_mrxnr(kc, Ap, Bp, C, ldc, epilogue);
+        return;
+    }
+
+    for (size_t i = 0; i < mr; i += BLOCK_SIZE) {
+        for (size_t j = 0; j < nr; j += BLOCK_SIZE) {
+            gemm_tile_epilogue_t ep;
+            process_block_edge(kc, MIN(BLOCK_SIZE, mr - i), MIN(BLOCK_SIZE, nr - j),
+                               &Ap[i * BLOCK_SIZE], RVM_MR * BLOCK_SIZE, &Bp[j * BLOCK_SIZE], RVM_NR * BLOCK_SIZE,
+                               &C[(i * ldc) + j], ldc, gemm_tile_epilogue_at(epilogue, i, j, &ep));
+        }
+    }
+}
+
+/**
+ * Stores an accumulator holding an mr x nr tile of C.
+ * Matrix registers can only be moved through memory, so with an epilogue the tile is stored
+ * to a buffer on the stack, which stays in L1, and goes to C through the vector registers
+ * with the biases and ReLU applied. GELU has no vector form and is applied to the stored tile.
+ */
+static inline void store_tile(float *C, const size_t ldc, const mfloat32_t c, const size_t mr, const size_t nr, const gemm_tile_epilogue_t *epilogue) {
+    if (epilogue == NULL) {
+        mst_f32_mf32(C, ldc * sizeof(float), c);
+        return;
+    }
+
+    float tile[BLOCK_SIZE * BLOCK_SIZE];
+    mst_f32_mf32(tile, TILE_STRIDE, c);
+    const size_t vl = vsetvl_e32m1(nr);
+    for (size_t i = 0; i < mr; i++) {
+        vfloat32m1_t row = vle32_v_f32m1(&tile[i * BLOCK_SIZE], vl);
+        if (epilogue->col_bias != NULL) {
+            row = vfadd_vv_f32m1(row, vle32_v_f32m1(epilogue->col_bias, vl), vl);
+        }
+        if (epilogue->row_bias != NULL) {
+            row = vfadd_vf_f32m1(row, epilogue->row_bias[i], vl);
+        }
+        if (epilogue->activation == GEMM_ACTIVATION_RELU) {
+            row = vfmax_vf_f32m1(row, 0.0f, vl);
+        }
+        vse32_v_f32m1(&C[i * ldc], row, vl);
+    }
+    if (epilogue->activation == GEMM_ACTIVATION_GELU) {
+        gemm_epilogue_activate(GEMM_ACTIVATION_GELU, mr, nr, C, ldc);
+    }
+}
+
+/**
+ * Computes C(4x4) += A(4xk) * B(kx4) keeping C in an accumulator register
+ * for the whole k loop. Consecutive tiles of the packed panels are ap_step and bp_step floats apart.
+ */
+static inline void process_block_4x4(const size_t k, const float *Ap, const size_t ap_step, const float *Bp, const size_t bp_step, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue) {
+    mfloat32_t c = mld_f32(C, ldc * sizeof(float));
+    for (size_t p = 0; p < k; p += BLOCK_SIZE) {
+        const mfloat32_t a = mld_f32(Ap, TILE_STRIDE);
+        const mfloat32_t b = mld_f32(Bp, TILE_STRIDE);
+        c = fmmacc_mf32(c, a, b);
+        Ap += ap_step;
+        Bp += bp_step;
+    }
+    store_tile(C, ldc, c, BLOCK_SIZE, BLOCK_SIZE, epilogue);
+}
+
+/**
+ * Computes an mr x nr edge tile of C (mr, nr <= 4). The tile goes through a 4x4 buffer on the stack, so the
+ * full-size matrix loads and stores never touch C outside the tile; the rows and columns the packed panels
+ * are padded with are zeros. The K tail needs no special handling since the panels are padded along K too.
+ */
+static inline void process_block_edge(const size_t k, const size_t mr, const size_t nr, const float *Ap, const size_t ap_step, const float *Bp, const size_t bp_step, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue) {
+    if ((mr == BLOCK_SIZE) && (nr == BLOCK_SIZE)) {
+        process_block_4x4(k, Ap, ap_step, Bp, bp_step, C, ldc, epilogue);
+        return;
+    }
+
+    float tile[BLOCK_SIZE * BLOCK_SIZE] = {0.0f};
+    for (size_t i = 0; i < mr; i++) {
+        memcpy(&tile[i * BLOCK_SIZE], &C[i * ldc], nr * sizeof(float));
+    }
+    mfloat32_t c = mld_f32(tile, TILE_STRIDE);
+    for (size_t p = 0; p < k; p += BLOCK_SIZE) {
+        c = fmmacc_mf32(c, mld_f32(Ap, TILE_STRIDE), mld_f32(Bp, TILE_STRIDE));
+        Ap += ap_step;
+        Bp += bp_step;
+    }
+
+    if (epilogue != NULL) {
+        // store_tile already goes through a buffer and stores mr rows of nr elements
+        store_tile(C, ldc, c, mr, nr, epilogue);
+        return;
+    }
+    mst_f32_mf32(tile, TILE_STRIDE, c);
+    for (size_t i = 0; i < mr; i++) {
+        memcpy(&C[i * ldc], &tile[i * BLOCK_SIZE], nr * sizeof(float));
+    }
+}
+
+#if RVM_TILE_SHAPE == RVM_TILE_2X2
+/**
+ * Computes C(8x8) += A(8xk) * B(kx8) with four accumulator registers.
+ * Two A tiles and two B tiles are loaded per step and each of them feeds two fmmacc.
+ */
+static inline void process_block_mrxnr(const size_t k, const float *Ap, const float *Bp, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue) {
+    const long stride_c = ldc * sizeof(float);
+    float *C1 = &C[BLOCK_SIZE * ldc];
+
+    mfloat32_t c00 = mld_f32(C, stride_c);
+    mfloat32_t c01 = mld_f32(&C[BLOCK_SIZE], stride_c);
+    mfloat32_t c10 = mld_f32(C1, stride_c);
+    mfloat32_t c11 = mld_f32(&C1[BLOCK_SIZE], stride_c);
+    for (size_t p = 0; p < k; p += BLOCK_SIZE) {
+        const mfloat32_t a0 = mld_f32(&Ap[0 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE);
+        const mfloat32_t a1 = mld_f32(&Ap[1 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE);
+        const mfloat32_t b0 = mld_f32(&Bp[0 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE);
+        const mfloat32_t b1 = mld_f32(&Bp[1 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE);
+        c00 = fmmacc_mf32(c00, a0, b0);
+        c01 = fmmacc_mf32(c01, a0, b1);
+        c10 = fmmacc_mf32(c10, a1, b0);
+        c11 = fmmacc_mf32(c11, a1, b1);
+        Ap += RVM_MR * BLOCK_SIZE;
+        Bp += RVM_NR * BLOCK_SIZE;
+    }
+    gemm_tile_epilogue_t ep;
+    store_tile(C, ldc, c00, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, 0, &ep));
+    store_tile(&C[BLOCK_SIZE], ldc, c01, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, BLOCK_SIZE, &ep));
+    store_tile(C1, ldc, c10, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, BLOCK_SIZE, 0, &ep));
+    store_tile(&C1[BLOCK_SIZE], ldc, c11, BLOCK_SIZE, BLOCK_SIZE,
+               gemm_tile_epilogue_at(epilogue, BLOCK_SIZE, BLOCK_SIZE, &ep));
+}
+#elif RVM_TILE_SHAPE == RVM_TILE_1X4
+/**
+ * Computes C(4x16) += A(4xk) * B(kx16) with four accumulator registers.
+ * One A tile is loaded per step and feeds four fmmacc.
+ */
+static inline void process_block_mrxnr(const size_t k, const float *Ap, const float *Bp, float *C, const size_t ldc, const gemm_tile_epilogue_t *epilogue) {
+    const long stride_c = ldc * sizeof(float);
+
+    mfloat32_t c0 = mld_f32(C, stride_c);
+    mfloat32_t c1 = mld_f32(&C[1 * BLOCK_SIZE], stride_c);
+    mfloat32_t c2 = mld_f32(&C[2 * BLOCK_SIZE], stride_c);
+    mfloat32_t c3 = mld_f32(&C[3 * BLOCK_SIZE], stride_c);
+    for (size_t p = 0; p < k; p += BLOCK_SIZE) {
+        const mfloat32_t a = mld_f32(Ap, TILE_STRIDE);
+        c0 = fmmacc_mf32(c0, a, mld_f32(&Bp[0 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE));
+        c1 = fmmacc_mf32(c1, a, mld_f32(&Bp[1 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE));
+        c2 = fmmacc_mf32(c2, a, mld_f32(&Bp[2 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE));
+        c3 = fmmacc_mf32(c3, a, mld_f32(&Bp[3 * BLOCK_SIZE * BLOCK_SIZE], TILE_STRIDE));
+        Ap += RVM_MR * BLOCK_SIZE;
+        Bp += RVM_NR * BLOCK_SIZE;
+    }
+    gemm_tile_epilogue_t ep;
+    store_tile(C, ldc, c0, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, 0 * BLOCK_SIZE, &ep));
+    store_tile(&C[1 * BLOCK_SIZE], ldc, c1, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, 1 * BLOCK_SIZE, &ep));
+    store_tile(&C[2 * BLOCK_SIZE], ldc, c2, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, 2 * BLOCK_SIZE, &ep));
+    store_tile(&C[3 * BLOCK_SIZE], ldc, c3, BLOCK_SIZE, BLOCK_SIZE, gemm_tile_epilogue_at(epilogue, 0, 3 * BLOCK_SIZE, &ep));
 }
+#endif // RVM_TILE_SHAPE
+#endif // RV64GVM
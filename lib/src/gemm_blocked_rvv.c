@@ -1,7 +1,282 @@
-#include "gemm.h"
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+#include <stdatomic.h>
 
 #define BLOCK_SIZE 4
 
+/*
+ * Register grouping used by gemm_block4x4_rvv: 1, 2, 4 or 8.
+ * Can be set from the build with -DRVV_LMUL=4.
+ * Every variant is also available as gemm_block4x4_rvv_m<LMUL>.
+ */
+#ifndef RVV_LMUL
+#define RVV_LMUL 1
+#endif
+
+#if (RVV_LMUL != 1) && (RVV_LMUL != 2) && (RVV_LMUL != 4) && (RVV_LMUL != 8)
+#error "Unsupported RVV_LMUL"
+#endif
+
+#define RVV_MICRO_KERNEL_(LMUL) micro_kernel_m##LMUL
+#define RVV_MICRO_KERNEL(LMUL) RVV_MICRO_KERNEL_(LMUL)
+#define RVV_PROBE_(LMUL) probe_m##LMUL
+#define RVV_PROBE(LMUL) RVV_PROBE_(LMUL)
+
+/*
+ * Vector register length in bits the micro-panels of B are packed for.
+ * Can be set from the build with -DRVV_VLEN=256.
+ * It is a lower bound of the VLEN of the target: a micro-panel row of NR columns must fit into one register group,
+ * harts with a shorter VLEN are rejected by the probe of the kernels and use the scalar kernel. The micro kernels
+ * rely on it: they are only run after the probe passed, by the dispatcher or by the entry points below.
+ */
+#ifndef RVV_VLEN
+#define RVV_VLEN 128
+#endif
+
+/*
+ * Rows of C computed together (MR). Four accumulators and a row of B take 5 * LMUL
+ * of the 32 vector registers, so with LMUL = 8 only two rows fit.
+ */
+#define RVV_MR_1 4
+#define RVV_MR_2 4
+#define RVV_MR_4 4
+#define RVV_MR_8 2
+
+#define RVV_MR_(LMUL) RVV_MR_##LMUL
+#define RVV_MR(LMUL) RVV_MR_(LMUL)
+
+// Columns of C computed together (NR): one vector register group.
+#define RVV_NR(LMUL) ((RVV_VLEN / 32) * (LMUL))
+
+#if defined(RV64GV) || defined(RV64GVM)
+/**
+ * Row kernel of the unpacked strategies: c[0 .. cols) += a[0 .. m) * B in strips of one LMUL = 8 register group.
+ * Only the accumulator and a row of B are live, so the widest grouping fits, and the rows of B are read
+ * with unit stride as in the scalar loop.
+ */
+extern void gemm_row_kernel_rvv(const size_t m, const size_t cols, const float *a, const float *B,
+                                const size_t ldb, float *c)
+{
+    for (size_t j = 0; j < cols;) {
+        const size_t vl = vsetvl_e32m8(cols - j);
+        vfloat32m8_t acc = vle32_v_f32m8(&c[j], vl);
+        for (size_t p = 0; p < m; p++) {
+            acc = vfmacc_vf_f32m8(acc, a[p], vle32_v_f32m8(&B[(p * ldb) + j], vl), vl);
+        }
+        vse32_v_f32m8(&c[j], acc, vl);
+        j += vl;
+    }
+}
+
+/*
+ * Adds the biases of row `row` of the tile to accumulator c and applies ReLU in the registers.
+ */
+#define RVV_EPILOGUE(LMUL, c, row, epilogue, vl)                                                                    \
+    do {                                                                                                            \
+        if ((epilogue)->col_bias != NULL) {                                                                         \
+            c = vfadd_vv_f32m##LMUL(c, vle32_v_f32m##LMUL((epilogue)->col_bias, vl), vl);                           \
+        }                                                                                                           \
+        if ((epilogue)->row_bias != NULL) {                                                                         \
+            c = vfadd_vf_f32m##LMUL(c, (epilogue)->row_bias[row], vl);                                              \
+        }                                                                                                           \
+        if ((epilogue)->activation == GEMM_ACTIVATION_RELU) {                                                       \
+            c = vfmax_vf_f32m##LMUL(c, 0.0f, vl);                                                                   \
+        }                                                                                                           \
+    } while (0)
+
+/*
+ * GELU has no vector form: it is applied to the rows of the tile right after they are stored, while they are in L1.
+ */
+#define RVV_EPILOGUE_GELU(rows, epilogue, C, ldc, vl)                                                               \
+    do {                                                                                                            \
+        if (((epilogue) != NULL) && ((epilogue)->activation == GEMM_ACTIVATION_GELU)) {                             \
+            gemm_epilogue_activate(GEMM_ACTIVATION_GELU, rows, vl, C, ldc);                                         \
+        }                                                                                                           \
+    } while (0)
+
+/*
+ * Defines the kernels for one register grouping:
+ *   process_block_4xv - C(4xvl) += A(4xk) * B(kxvl), every row of the B micro-panel is loaded once
+ *                       and multiplied by four broadcast elements of the A micro-panel;
+ *   process_block_2xv - the same for two rows;
+ *   process_block_1xv - the same for one row;
+ *   micro_kernel      - C(mr x nr) += Ap * Bp, vsetvl handles tiles narrower than NR;
+ * and the gemm_kernel_rvv_m<LMUL> descriptor. The epilogue is applied to the accumulators before they are stored.
+ */
+#define DEFINE_RVV_GEMM(LMUL)                                                                                       \
+static inline void process_block_4xv_m##LMUL(const size_t k, const float *Ap, const size_t ap_step,                 \
+                                             const float *Bp, const size_t bp_step,                                 \
+                                             float *C, const size_t ldc, const size_t vl,                           \
+                                             const gemm_tile_epilogue_t *epilogue) {                                \
+    vfloat32m##LMUL##_t c0 = vle32_v_f32m##LMUL(&C[0 * ldc], vl);                                                   \
+    vfloat32m##LMUL##_t c1 = vle32_v_f32m##LMUL(&C[1 * ldc], vl);                                                   \
+    vfloat32m##LMUL##_t c2 = vle32_v_f32m##LMUL(&C[2 * ldc], vl);                                                   \
+    vfloat32m##LMUL##_t c3 = vle32_v_f32m##LMUL(&C[3 * ldc], vl);                                                   \
+    for (size_t p = 0; p < k; p += 1) {                                                                             \
+        const float *a = &Ap[p * ap_step];                                                                          \
+        const vfloat32m##LMUL##_t b = vle32_v_f32m##LMUL(&Bp[p * bp_step], vl);                                     \
+        c0 = vfmacc_vf_f32m##LMUL(c0, a[0], b, vl);                                                                 \
+        c1 = vfmacc_vf_f32m##LMUL(c1, a[1], b, vl);                                                                 \
+        c2 = vfmacc_vf_f32m##LMUL(c2, a[2], b, vl);                                                                 \
+        c3 = vfmacc_vf_f32m##LMUL(c3, a[3], b, vl);                                                                 \
+    }                                                                                                               \
+    if (epilogue != NULL) {                                                                                         \
+        RVV_EPILOGUE(LMUL, c0, 0, epilogue, vl);                                                                    \
+        RVV_EPILOGUE(LMUL, c1, 1, epilogue, vl);                                                                    \
+        RVV_EPILOGUE(LMUL, c2, 2, epilogue, vl);                                                                    \
+        RVV_EPILOGUE(LMUL, c3, 3, epilogue, vl);                                                                    \
+    }                                                                                                               \
+    vse32_v_f32m##LMUL(&C[0 * ldc], c0, vl);                                                                        \
+    vse32_v_f32m##LMUL(&C[1 * ldc], c1, vl);                                                                        \
+    vse32_v_f32m##LMUL(&C[2 * ldc], c2, vl);                                                                        \
+    vse32_v_f32m##LMUL(&C[3 * ldc], c3, vl);                                                                        \
+    RVV_EPILOGUE_GELU(4, epilogue, C, ldc, vl);                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void process_block_2xv_m##LMUL(const size_t k, const float *Ap, const size_t ap_step,                 \
+                                             const float *Bp, const size_t bp_step,                                 \
+                                             float *C, const size_t ldc, const size_t vl,                           \
+                                             const gemm_tile_epilogue_t *epilogue) {                                \
+    vfloat32m##LMUL##_t c0 = vle32_v_f32m##LMUL(&C[0 * ldc], vl);                                                   \
+    vfloat32m##LMUL##_t c1 = vle32_v_f32m##LMUL(&C[1 * ldc], vl);                                                   \
+    for (size_t p = 0; p < k; p += 1) {                                                                             \
+        const float *a = &Ap[p * ap_step];                                                                          \
+        const vfloat32m##LMUL##_t b = vle32_v_f32m##LMUL(&Bp[p * bp_step], vl);                                     \
+        c0 = vfmacc_vf_f32m##LMUL(c0, a[0], b, vl);                                                                 \
+        c1 = vfmacc_vf_f32m##LMUL(c1, a[1], b, vl);                                                                 \
+    }                                                                                                               \
+    if (epilogue != NULL) {                                                                                         \
+        RVV_EPILOGUE(LMUL, c0, 0, epilogue, vl);                                                                    \
+        RVV_EPILOGUE(LMUL, c1, 1, epilogue, vl);                                                                    \
+    }                                                                                                               \
+    vse32_v_f32m##LMUL(&C[0 * ldc], c0, vl);                                                                        \
+    vse32_v_f32m##LMUL(&C[1 * ldc], c1, vl);                                                                        \
+    RVV_EPILOGUE_GELU(2, epilogue, C, ldc, vl);                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void process_block_1xv_m##LMUL(const size_t k, const float *Ap, const size_t ap_step,                 \
+                                             const float *Bp, const size_t bp_step,                                 \
+                                             float *C, const size_t vl,                                             \
+                                             const gemm_tile_epilogue_t *epilogue) {                                \
+    vfloat32m##LMUL##_t c = vle32_v_f32m##LMUL(C, vl);                                                              \
+    for (size_t p = 0; p < k; p += 1) {                                                                             \
+        c = vfmacc_vf_f32m##LMUL(c, Ap[p * ap_step], vle32_v_f32m##LMUL(&Bp[p * bp_step], vl), vl);                 \
+    }                                                                                                               \
+    if (epilogue != NULL) {                                                                                         \
+        RVV_EPILOGUE(LMUL, c, 0, epilogue, vl);                                                                     \
+    }                                                                                                               \
+    vse32_v_f32m##LMUL(C, c, vl);                                                                                   \
+    RVV_EPILOGUE_GELU(1, epilogue, C, 0, vl);                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+/* The hart implements RVV 0.7.1 and one register group holds a micro-panel row of NR columns */               \
+static int probe_m##LMUL(void) {                                                                                    \
+    return gemm_probe_rvv_0p7() && (vsetvl_e32m##LMUL(RVV_NR(LMUL)) == RVV_NR(LMUL));                               \
+}                                                                                                                   \
+                                                                                                                    \
+static void micro_kernel_m##LMUL(const size_t kc, const float *Ap, const float *Bp,                                 \
+                                 float *C, const size_t ldc, const size_t mr, const size_t nr,                      \
+                                 const gemm_tile_epilogue_t *epilogue)                                              \
+{                                                                                                                   \
+    const size_t vl = vsetvl_e32m##LMUL(nr);                                                                        \
+                                                                                                                    \
+    if ((RVV_MR_##LMUL == 4) && (mr == 4)) {                                                                        \
+        process_block_4xv_m##LMUL(kc, Ap, RVV_MR_##LMUL, Bp, RVV_NR(LMUL), C, ldc, vl, epilogue);                   \
+        return;                                                                                                     \
+    }                                                                                                               \
+                                                                                                                    \
+    size_t i = 0;                                                                                                   \
+    gemm_tile_epilogue_t ep;                                                                                        \
+    for (; i + 2 <= mr; i += 2) {                                                                                   \
+        process_block_2xv_m##LMUL(kc, &Ap[i], RVV_MR_##LMUL, Bp, RVV_NR(LMUL), &C[i * ldc], ldc, vl,                \
+                                  gemm_tile_epilogue_at(epilogue, i, 0, &ep));                                      \
+    }                                                                                                               \
+    for (; i < mr; i += 1) {                                                                                        \
+        process_block_1xv_m##LMUL(kc, &Ap[i], RVV_MR_##LMUL, Bp, RVV_NR(LMUL), &C[i * ldc], vl,                     \
+                                  gemm_tile_epilogue_at(epilogue, i, 0, &ep));                                      \
+    }                                                                                                               \
+}                                                                                                                   \
+                                                                                                                    \
+const gemm_kernel_t gemm_kernel_rvv_m##LMUL = {                                                                     \
+    .name = "rvv_m" #LMUL,                                                                                          \
+    .mr = RVV_MR_##LMUL,                                                                                            \
+    .nr = RVV_NR(LMUL),                                                                                             \
+    .kr = 1,                                                                                                        \
+    .setup = NULL,                                                                                                  \
+    .micro_kernel = micro_kernel_m##LMUL,                                                                           \
+    .probe = probe_m##LMUL,                                                                                         \
+    .row_kernel = gemm_row_kernel_rvv,                                                                              \
+};
+#else
+#define DEFINE_RVV_GEMM(LMUL)                                                                                       \
+const gemm_kernel_t gemm_kernel_rvv_m##LMUL = {                                                                     \
+    .name = "rvv_m" #LMUL,                                                                                          \
+    .mr = GEMM_REF_MR,                                                                                              \
+    .nr = GEMM_REF_NR,                                                                                              \
+    .kr = 1,                                                                                                        \
+    .setup = NULL,                                                                                                  \
+    .micro_kernel = gemm_micro_kernel_ref,                                                                          \
+    .probe = NULL,                                                                                                  \
+    .row_kernel = NULL,                                                                                             \
+};
+#endif // RV64GV || RV64GVM
+
+DEFINE_RVV_GEMM(1)
+DEFINE_RVV_GEMM(2)
+DEFINE_RVV_GEMM(4)
+DEFINE_RVV_GEMM(8)
+
+#if defined(RV64GV) || defined(RV64GVM)
+const gemm_kernel_t gemm_kernel_rvv = {
+    .name = "rvv",
+    .mr = RVV_MR(RVV_LMUL),
+    .nr = RVV_NR(RVV_LMUL),
+    .kr = 1,
+    .setup = NULL,
+    .micro_kernel = RVV_MICRO_KERNEL(RVV_LMUL),
+    .probe = RVV_PROBE(RVV_LMUL),
+    .row_kernel = gemm_row_kernel_rvv,
+};
+#else
+const gemm_kernel_t gemm_kernel_rvv = {
+    .name = "rvv",
+    .mr = GEMM_REF_MR,
+    .nr = GEMM_REF_NR,
+    .kr = 1,
+    .setup = NULL,
+    .micro_kernel = gemm_micro_kernel_ref,
+    .probe = NULL,
+    .row_kernel = NULL,
+};
+#endif // RV64GV || RV64GVM
+
+/*
+ * Results of the probes of the kernels the entry points run: 0 - not run yet, 1 - passed, -1 - failed.
+ * Threads racing on the first call may both run the probe, gemm_run_probe serializes them.
+ */
+static _Atomic int probed_rvv;
+static _Atomic int probed_m1;
+static _Atomic int probed_m2;
+static _Atomic int probed_m4;
+static _Atomic int probed_m8;
+
+/**
+ * Returns the kernel if the hart runs it and the scalar kernel otherwise, e.g. on harts whose VLEN is shorter
+ * than RVV_VLEN. The probe runs once per kernel, its result is kept in probed.
+ */
+static const gemm_kernel_t *checked_kernel(const gemm_kernel_t *kernel, _Atomic int *probed) {
+    if (kernel->probe == NULL) {
+        return kernel;
+    }
+    int result = atomic_load(probed);
+    if (result == 0) {
+        result = gemm_run_probe(kernel->probe) ? 1 : -1;
+        atomic_store(probed, result);
+    }
+    return (result > 0) ? kernel : &gemm_kernel_ref;
+}
+
 /**
  * Multiplies two matrices A and B with dimensions n x m and m x k respectively
  * using a block-based approach and RISC-V Vector extension.
@@ -15,6 +290,68 @@
  */
 extern void gemm_block4x4_rvv(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
 {
-    // Just a placeholder.
-    gemm_ref(A, B, C, n, m, k);  
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver(checked_kernel(&gemm_kernel_rvv, &probed_rvv), NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C using RISC-V Vector extension, see sgemm.
+ */
+extern int sgemm_rvv(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                     const size_t M, const size_t N, const size_t K, const float alpha,
+                     const float *A, const size_t lda, const float *B, const size_t ldb,
+                     const float beta, float *C, const size_t ldc)
+{
+    const int info = gemm_sgemm_check(layout, transA, transB, M, N, K, lda, ldb, ldc);
+    if (info != 0) {
+        return info;
+    }
+
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, M, K, N);
+    gemm_sgemm(checked_kernel(&gemm_kernel_rvv, &probed_rvv), layout, transA, transB, M, N, K, alpha, A, lda, B, ldb,
+               beta, C, ldc);
+    GEMM_TRACE_END();
+    return 0;
+}
+
+/**
+ * Computes C = act(alpha * A * B + beta * C + col_bias + row_bias) using RISC-V Vector extension,
+ * see gemm_block4x4_rvm_epilogue.
+ */
+extern void gemm_block4x4_rvv_epilogue(const float *A, const float *B, float *C,
+                                       const size_t n, const size_t m, const size_t k,
+                                       const gemm_epilogue_t *epilogue)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver_epilogue(checked_kernel(&gemm_kernel_rvv, &probed_rvv), A, B, C, n, m, k, epilogue);
+    GEMM_TRACE_END();
+}
+
+extern void gemm_block4x4_rvv_m1(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver(checked_kernel(&gemm_kernel_rvv_m1, &probed_m1), NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+extern void gemm_block4x4_rvv_m2(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver(checked_kernel(&gemm_kernel_rvv_m2, &probed_m2), NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+extern void gemm_block4x4_rvv_m4(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver(checked_kernel(&gemm_kernel_rvv_m4, &probed_m4), NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
+}
+
+extern void gemm_block4x4_rvv_m8(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVV, n, m, k);
+    gemm_driver(checked_kernel(&gemm_kernel_rvv_m8, &probed_m8), NULL, A, m, B, k, C, k, n, m, k);
+    GEMM_TRACE_END();
 }
@@ -0,0 +1,172 @@
+#include "gemm_kernel.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/**
+ * Kernel of a backend.
+ */
+typedef struct backend {
+    const char *name; /* Value of RMVGEMM_BACKEND */
+    const gemm_kernel_t *kernel;
+} backend_t;
+
+static const backend_t backends[] = {
+    [GEMM_BACKEND_REF] = {"ref", &gemm_kernel_ref},
+    [GEMM_BACKEND_RVV] = {"rvv", &gemm_kernel_rvv},
+    [GEMM_BACKEND_RVM] = {"rvm", &gemm_kernel_rvm},
+};
+
+#define BACKEND_COUNT (sizeof(backends) / sizeof(backends[0]))
+
+/*
+ * Dispatch table, filled once by detect().
+ */
+static struct {
+    pthread_once_t once;
+    int supported[BACKEND_COUNT];
+    _Atomic(const backend_t *) selected;
+} dispatch = {
+    .once = PTHREAD_ONCE_INIT,
+};
+
+/*
+ * The SIGILL handler is process-wide, probes from different threads take turns.
+ */
+static pthread_mutex_t probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static sigjmp_buf probe_env;
+
+static void probe_sigill(int signal) {
+    (void)signal;
+    siglongjmp(probe_env, 1);
+}
+
+/**
+ * Runs a probe which executes an instruction the hart may not implement (or may not allow in user mode).
+ *
+ * @return Result of the probe, 0 if it raised SIGILL.
+ */
+extern int gemm_run_probe(int (*probe)(void))
+{
+    struct sigaction action;
+    struct sigaction previous;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = probe_sigill;
+    sigemptyset(&action.sa_mask);
+
+    pthread_mutex_lock(&probe_lock);
+    volatile int supported = 0;
+    if (sigaction(SIGILL, &action, &previous) == 0) {
+        if (sigsetjmp(probe_env, 1) == 0) {
+            supported = probe();
+        }
+        sigaction(SIGILL, &previous, NULL);
+    }
+    pthread_mutex_unlock(&probe_lock);
+    return supported;
+}
+
+/**
+ * Checks that the hart runs the kernel. The probe executes an instruction of the extension:
+ * harts without it raise SIGILL, which is caught by gemm_run_probe. Trapping is used instead of hwcap and
+ * /proc/cpuinfo since the vendor kernels do not report RVV 0.7.1 and the matrix extension there.
+ */
+static int kernel_supported(const gemm_kernel_t *kernel) {
+    return (kernel->probe == NULL) || gemm_run_probe(kernel->probe);
+}
+
+/**
+ * Checks that the backend is built with its extension and the hart runs it.
+ * On targets without an extension its kernel is the scalar one and brings nothing over GEMM_BACKEND_REF.
+ */
+static int backend_supported(const gemm_backend_t backend) {
+    const gemm_kernel_t *kernel = backends[backend].kernel;
+    if ((backend != GEMM_BACKEND_REF) && (kernel->micro_kernel == gemm_micro_kernel_ref)) {
+        return 0;
+    }
+    return kernel_supported(kernel);
+}
+
+static void select_backend(const gemm_backend_t backend) {
+    atomic_store(&dispatch.selected, &backends[backend]);
+}
+
+/**
+ * Probes the backends and selects the last supported one, the backends are listed from the slowest
+ * to the fastest. RMVGEMM_BACKEND names the backend to use instead, if the hart supports it.
+ */
+static void detect(void) {
+    gemm_backend_t best = GEMM_BACKEND_REF;
+    for (size_t i = 0; i < BACKEND_COUNT; i++) {
+        dispatch.supported[i] = backend_supported((gemm_backend_t)i);
+        if (dispatch.supported[i]) {
+            best = (gemm_backend_t)i;
+        }
+    }
+
+    const char *env = getenv("RMVGEMM_BACKEND");
+    gemm_backend_t backend;
+    if ((env != NULL) && (gemm_backend_by_name(env, &backend) == 0) && dispatch.supported[backend]) {
+        best = backend;
+    }
+    select_backend(best);
+}
+
+static const backend_t *selected_backend(void) {
+    pthread_once(&dispatch.once, detect);
+    return atomic_load(&dispatch.selected);
+}
+
+extern gemm_backend_t gemm_get_backend(void)
+{
+    return (gemm_backend_t)(selected_backend() - backends);
+}
+
+extern int gemm_set_backend(const gemm_backend_t backend)
+{
+    pthread_once(&dispatch.once, detect);
+    if (((size_t)backend >= BACKEND_COUNT) || !dispatch.supported[backend]) {
+        return -1;
+    }
+    select_backend(backend);
+    return 0;
+}
+
+/**
+ * Kernel of the backend selected for this hart, see gemm_set_backend.
+ */
+extern const gemm_kernel_t *gemm_dispatch_kernel(void)
+{
+    return selected_backend()->kernel;
+}
+
+/**
+ * Kernel of the backend if it is built and the hart supports it, NULL otherwise.
+ */
+extern const gemm_kernel_t *gemm_backend_kernel(const gemm_backend_t backend)
+{
+    pthread_once(&dispatch.once, detect);
+    if (((size_t)backend >= BACKEND_COUNT) || !dispatch.supported[backend]) {
+        return NULL;
+    }
+    return backends[backend].kernel;
+}
+
+/**
+ * Backend named as in RMVGEMM_BACKEND (ref, rvv or rvm).
+ *
+ * @return 0 on success, -1 if the name is unknown.
+ */
+extern int gemm_backend_by_name(const char *name, gemm_backend_t *backend)
+{
+    for (size_t i = 0; i < BACKEND_COUNT; i++) {
+        if (strcmp(name, backends[i].name) == 0) {
+            *backend = (gemm_backend_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
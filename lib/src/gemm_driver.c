@@ -0,0 +1,797 @@
+#include "gemm_kernel.h"
+#include "gemm_thread.h"
+
+/*
+ * Macro-tiles of C per thread in the parallel driver. More tiles balance better,
+ * but every tile packs its own blocks of A and B.
+ */
+#ifndef GEMM_TASKS_PER_THREAD
+#define GEMM_TASKS_PER_THREAD 4
+#endif
+
+/*
+ * Height of the macro-tiles of grouped GEMM in MC blocks, the width is NC.
+ * All problems of a group are cut into tiles of the same size, so that the tiles of
+ * small and large problems are scheduled together.
+ */
+#ifndef GEMM_GROUP_ROW_BLOCKS
+#define GEMM_GROUP_ROW_BLOCKS 4
+#endif
+
+/*
+ * Largest dimension of a leaf of the recursive driver. Leaves only amortize the packing and the calls,
+ * the operands of a 64x64x64 leaf (48 KB) fit in L2 of any core and the recursion above finds the
+ * levels of the cache hierarchy by itself.
+ */
+#ifndef GEMM_RECURSIVE_LEAF
+#define GEMM_RECURSIVE_LEAF 64
+#endif
+
+/**
+ * Computes one problem on the calling thread.
+ */
+typedef void (*serial_driver_t)(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args);
+
+const gemm_blocking_t gemm_default_blocking = {
+    .mc = GEMM_MC,
+    .kc = GEMM_KC,
+    .nc = GEMM_NC,
+};
+
+static void macro_kernel(const gemm_kernel_t *kernel, const size_t mc, const size_t kc, const size_t nc,
+                         const float *Ap, const float *Bp, float *C, const size_t ldc,
+                         const gemm_tile_epilogue_t *epilogue);
+static void driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args);
+static void recursive_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args);
+static void serial_batch(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                         const gemm_args_t *args, const size_t count);
+static void parallel_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                            const size_t max_threads);
+static void split_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                         const size_t max_threads, serial_driver_t serial);
+static void batch_task(void *arg, const size_t task);
+static void grouped_task(void *arg, const size_t task);
+static size_t grouped_col_tiles(const gemm_blocking_t *blocking, const gemm_args_t *args);
+
+/**
+ * Arguments of the parallel driver tasks. C is split into a grid of row_tiles x col_tiles macro-tiles,
+ * one per task, tile borders are on multiples of the micro tile. Every tile is computed by `serial`.
+ */
+typedef struct parallel_gemm {
+    const gemm_kernel_t *kernel;
+    const gemm_blocking_t *blocking;
+    const gemm_args_t *args;
+    serial_driver_t serial;
+    size_t row_tiles;
+    size_t col_tiles;
+} parallel_gemm_t;
+
+/**
+ * Arguments of the batch tasks: the problems are split into `chunks` contiguous runs, one per task.
+ */
+typedef struct batch_gemm {
+    const gemm_kernel_t *kernel;
+    const gemm_blocking_t *blocking;
+    const gemm_args_t *args;
+    size_t count;
+    size_t chunks;
+} batch_gemm_t;
+
+/**
+ * Arguments of the grouped GEMM tasks: problem i owns tasks first_tile[i] .. first_tile[i + 1] - 1,
+ * one per macro-tile of tile_rows x blocking->nc elements of its C.
+ */
+typedef struct grouped_gemm {
+    const gemm_kernel_t *kernel;
+    const gemm_blocking_t *blocking;
+    const gemm_args_t *args;
+    size_t count;
+    const size_t *first_tile;
+    size_t tile_rows;
+} grouped_gemm_t;
+
+/**
+ * Allocates a packing buffer of the given number of floats.
+ */
+static float *alloc_pack_buffer(const size_t count) {
+    const size_t bytes = ROUND_UP(count * sizeof(float), GEMM_PACK_ALIGN);
+    return (float *)aligned_alloc(GEMM_PACK_ALIGN, bytes);
+}
+
+/**
+ * Computes C = beta * C for a rows x cols block, beta = 0 overwrites C without reading it.
+ */
+static void scale_c(const size_t rows, const size_t cols, const float beta, float *C, const size_t ldc) {
+    if (beta == 1.0f) {
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            C[(i * ldc) + j] = (beta == 0.0f) ? 0.0f : (beta * C[(i * ldc) + j]);
+        }
+    }
+}
+
+/**
+ * Operands of the rows x cols block of C starting at row r0 and column c0.
+ * Pre-packed B keeps all its columns, so c0 must be 0 for it.
+ */
+static gemm_args_t sub_problem(const gemm_args_t *args, const size_t r0, const size_t c0,
+                               const size_t rows, const size_t cols)
+{
+    gemm_args_t part = *args;
+    part.n = rows;
+    part.k = cols;
+    part.A = &args->A[r0 * args->rs_a];
+    part.B = (args->B != NULL) ? &args->B[c0 * args->cs_b] : NULL;
+    part.C = &args->C[(r0 * args->ldc) + c0];
+    part.row_bias = (args->row_bias != NULL) ? &args->row_bias[r0] : NULL;
+    part.col_bias = (args->col_bias != NULL) ? &args->col_bias[c0] : NULL;
+    return part;
+}
+
+/**
+ * Epilogue of the block of C starting at row i and column j.
+ *
+ * @return ep filled for the block, NULL if the problem has no epilogue.
+ */
+static const gemm_tile_epilogue_t *block_epilogue(const gemm_args_t *args, const size_t i, const size_t j,
+                                                  gemm_tile_epilogue_t *ep)
+{
+    if ((args->row_bias == NULL) && (args->col_bias == NULL) && (args->activation == GEMM_ACTIVATION_NONE)) {
+        return NULL;
+    }
+    const gemm_tile_epilogue_t whole = {
+        .row_bias = args->row_bias,
+        .col_bias = args->col_bias,
+        .activation = args->activation,
+    };
+    return gemm_tile_epilogue_at(&whole, i, j, ep);
+}
+
+/**
+ * Computes C += A * B splitting the matrices into MC x KC blocks of A and KC x NC blocks of B.
+ * Every block is packed into micro-panels and multiplied by the micro kernel tile by tile.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param A Pointer to the first matrix (size n x m).
+ * @param lda Leading dimension of A.
+ * @param B Pointer to the second matrix (size m x k).
+ * @param ldb Leading dimension of B.
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param ldc Leading dimension of C.
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ */
+extern void gemm_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                        const float *A, const size_t lda, const float *B, const size_t ldb, float *C, const size_t ldc,
+                        const size_t n, const size_t m, const size_t k)
+{
+    const gemm_args_t args = {
+        .n = n,
+        .m = m,
+        .k = k,
+        .alpha = 1.0f,
+        .A = A,
+        .rs_a = lda,
+        .cs_a = 1,
+        .B = B,
+        .rs_b = ldb,
+        .cs_b = 1,
+        .B_packed = NULL,
+        .beta = 1.0f,
+        .C = C,
+        .ldc = ldc,
+        .row_bias = NULL,
+        .col_bias = NULL,
+        .activation = GEMM_ACTIVATION_NONE,
+    };
+    gemm_driver_args(kernel, blocking, &args);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C with the blocked driver.
+ * alpha is applied while A is packed and beta to every block of C before its first update.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands.
+ */
+extern void gemm_driver_args(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args)
+{
+    gemm_driver_threads(kernel, blocking, args, gemm_get_num_threads());
+}
+
+/**
+ * gemm_driver_args on at most `threads` threads.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands.
+ * @param threads Upper bound of the number of threads, values above gemm_get_num_threads() do not add threads.
+ */
+extern void gemm_driver_threads(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                                const size_t threads)
+{
+    parallel_driver(kernel, (blocking != NULL) ? blocking : &gemm_default_blocking, args, threads);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C with the cache-oblivious recursive driver.
+ * C is split between the threads as in the blocked driver, every macro-tile is computed recursively:
+ * the largest of n, m and k is halved until all of them are at most GEMM_RECURSIVE_LEAF, then the leaf
+ * is packed and multiplied by the micro kernel. Halves are on multiples of the register blocks
+ * (and of 4 along m), so every leaf but the last ones along each dimension is made of full tiles.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param args Operands, B must not be pre-packed.
+ * @param threads Upper bound of the number of threads, values above gemm_get_num_threads() do not add threads.
+ */
+extern void gemm_driver_recursive(const gemm_kernel_t *kernel, const gemm_args_t *args, const size_t threads)
+{
+    split_driver(kernel, &gemm_default_blocking, args, threads, recursive_driver);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C for several independent problems.
+ * Problems too small to be split between threads are distributed between threads as a whole,
+ * contiguous runs of them share the packing buffers and the kernel setup.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands of every problem.
+ * @param count Number of problems.
+ */
+extern void gemm_driver_batch(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                              const gemm_args_t *args, const size_t count)
+{
+    if (blocking == NULL) {
+        blocking = &gemm_default_blocking;
+    }
+
+    const size_t threads = gemm_get_num_threads();
+    const size_t threshold = gemm_get_parallel_threshold();
+    size_t total_work = 0;
+    size_t max_work = 0;
+    for (size_t i = 0; i < count; i++) {
+        const size_t work = args[i].n * args[i].m * args[i].k;
+        total_work += work;
+        max_work = MAX(max_work, work);
+    }
+
+    if (count <= 1) {
+        if (count == 1) {
+            parallel_driver(kernel, blocking, args, threads);
+        }
+        return;
+    }
+    if ((threads == 1) || (total_work < threshold)) {
+        serial_batch(kernel, blocking, args, count);
+        return;
+    }
+
+    if ((count < threads) && (max_work >= threshold)) {
+        // Few large problems: split every problem between the threads.
+        for (size_t i = 0; i < count; i++) {
+            parallel_driver(kernel, blocking, &args[i], threads);
+        }
+        return;
+    }
+
+    batch_gemm_t g = {
+        .kernel = kernel,
+        .blocking = blocking,
+        .args = args,
+        .count = count,
+        .chunks = MIN(count, threads * GEMM_TASKS_PER_THREAD),
+    };
+    gemm_parallel_for(g.chunks, batch_task, &g);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C for problems of different shapes.
+ * All problems are cut into macro-tiles of the same size which are scheduled on the thread pool
+ * together, so small problems run alongside large ones instead of one after another.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands of every problem.
+ * @param count Number of problems.
+ */
+extern void gemm_driver_grouped(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                                const gemm_args_t *args, const size_t count)
+{
+    if (blocking == NULL) {
+        blocking = &gemm_default_blocking;
+    }
+
+    size_t total_work = 0;
+    for (size_t i = 0; i < count; i++) {
+        total_work += args[i].n * args[i].m * args[i].k;
+    }
+    size_t *first_tile = NULL;
+    if ((gemm_get_num_threads() > 1) && (total_work >= gemm_get_parallel_threshold())) {
+        first_tile = (size_t *)malloc((count + 1) * sizeof(size_t));
+    }
+    if (first_tile == NULL) {
+        serial_batch(kernel, blocking, args, count);
+        return;
+    }
+
+    const size_t tile_rows = blocking->mc * GEMM_GROUP_ROW_BLOCKS;
+    first_tile[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        const size_t row_tiles = (args[i].n + tile_rows - 1) / tile_rows;
+        first_tile[i + 1] = first_tile[i] + (row_tiles * grouped_col_tiles(blocking, &args[i]));
+    }
+
+    grouped_gemm_t g = {
+        .kernel = kernel,
+        .blocking = blocking,
+        .args = args,
+        .count = count,
+        .first_tile = first_tile,
+        .tile_rows = tile_rows,
+    };
+    gemm_parallel_for(first_tile[count], grouped_task, &g);
+
+    free(first_tile);
+}
+
+/**
+ * Computes C += A * B for B packed in advance with gemm_pack_b_blocks.
+ *
+ * @param packed Packed matrix B (size m x k).
+ * @param A Pointer to the first matrix (size n x m).
+ * @param lda Leading dimension of A.
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param ldc Leading dimension of C.
+ * @param n Number of rows in matrix A and resulting matrix C.
+ */
+extern void gemm_driver_prepacked(const gemm_packed_b *packed, const float *A, const size_t lda,
+                                  float *C, const size_t ldc, const size_t n)
+{
+    const gemm_args_t args = {
+        .n = n,
+        .m = packed->m,
+        .k = packed->k,
+        .alpha = 1.0f,
+        .A = A,
+        .rs_a = lda,
+        .cs_a = 1,
+        .B = NULL,
+        .rs_b = 0,
+        .cs_b = 0,
+        .B_packed = packed->data,
+        .beta = 1.0f,
+        .C = C,
+        .ldc = ldc,
+        .row_bias = NULL,
+        .col_bias = NULL,
+        .activation = GEMM_ACTIVATION_NONE,
+    };
+    parallel_driver(packed->kernel, &packed->blocking, &args, gemm_get_num_threads());
+}
+
+/**
+ * Packs the whole matrix B block by block in the order the driver consumes them.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param blocking Panel sizes.
+ * @param B Pointer to the matrix (size m x k).
+ * @param rs Distance between rows of B.
+ * @param cs Distance between columns of B.
+ * @param m Number of rows in B.
+ * @param k Number of columns in B.
+ * @param Bp Destination, gemm_pack_b_blocks_size(kernel, blocking, m, k) floats.
+ */
+extern void gemm_pack_b_blocks(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                               const float *B, const size_t rs, const size_t cs, const size_t m, const size_t k,
+                               float *Bp)
+{
+    for (size_t jc = 0; jc < k; jc += blocking->nc) {
+        const size_t nc = MIN(blocking->nc, k - jc);
+        for (size_t pc = 0; pc < m; pc += blocking->kc) {
+            const size_t kc = MIN(blocking->kc, m - pc);
+            gemm_pack_b_block(kernel, kc, nc, &B[(pc * rs) + (jc * cs)], rs, cs, Bp);
+            Bp += gemm_pack_b_size(kernel, kc, nc);
+        }
+    }
+}
+
+/**
+ * Number of floats of the whole matrix B packed with gemm_pack_b_blocks.
+ */
+extern size_t gemm_pack_b_blocks_size(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                                      const size_t m, const size_t k)
+{
+    size_t size = 0;
+    for (size_t jc = 0; jc < k; jc += blocking->nc) {
+        for (size_t pc = 0; pc < m; pc += blocking->kc) {
+            size += gemm_pack_b_size(kernel, MIN(blocking->kc, m - pc), MIN(blocking->nc, k - jc));
+        }
+    }
+    return size;
+}
+
+/**
+ * Start of part `index` of `units` micro tiles split into `parts` nearly equal parts, in elements.
+ */
+static size_t split_point(const size_t units, const size_t parts, const size_t index, const size_t tile, const size_t size) {
+    return MIN(((units * index) / parts) * tile, size);
+}
+
+static void parallel_task(void *arg, const size_t task) {
+    const parallel_gemm_t *g = (const parallel_gemm_t *)arg;
+    const gemm_args_t *args = g->args;
+    const size_t row_units = (args->n + g->kernel->mr - 1) / g->kernel->mr;
+    const size_t col_units = (args->k + g->kernel->nr - 1) / g->kernel->nr;
+    const size_t ti = task / g->col_tiles;
+    const size_t tj = task % g->col_tiles;
+
+    const size_t r0 = split_point(row_units, g->row_tiles, ti, g->kernel->mr, args->n);
+    const size_t r1 = split_point(row_units, g->row_tiles, ti + 1, g->kernel->mr, args->n);
+    const size_t c0 = split_point(col_units, g->col_tiles, tj, g->kernel->nr, args->k);
+    const size_t c1 = split_point(col_units, g->col_tiles, tj + 1, g->kernel->nr, args->k);
+
+    const gemm_args_t tile = sub_problem(args, r0, c0, r1 - r0, c1 - c0);
+    g->serial(g->kernel, g->blocking, &tile);
+}
+
+static void batch_task(void *arg, const size_t task) {
+    const batch_gemm_t *g = (const batch_gemm_t *)arg;
+    const size_t first = (g->count * task) / g->chunks;
+    const size_t last = (g->count * (task + 1)) / g->chunks;
+    serial_batch(g->kernel, g->blocking, &g->args[first], last - first);
+}
+
+/**
+ * Number of macro-tile columns of a problem in grouped GEMM, pre-packed B is not split.
+ */
+static size_t grouped_col_tiles(const gemm_blocking_t *blocking, const gemm_args_t *args) {
+    return (args->B_packed == NULL) ? ((args->k + blocking->nc - 1) / blocking->nc) : 1;
+}
+
+static void grouped_task(void *arg, const size_t task) {
+    const grouped_gemm_t *g = (const grouped_gemm_t *)arg;
+
+    // Find the problem of the task: the last one with first_tile <= task.
+    size_t lo = 0;
+    size_t hi = g->count;
+    while (hi - lo > 1) {
+        const size_t mid = lo + ((hi - lo) / 2);
+        if (g->first_tile[mid] <= task) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    const gemm_args_t *args = &g->args[lo];
+    const size_t col_tiles = grouped_col_tiles(g->blocking, args);
+    const size_t tile = task - g->first_tile[lo];
+
+    const size_t r0 = (tile / col_tiles) * g->tile_rows;
+    const size_t c0 = (tile % col_tiles) * g->blocking->nc;
+
+    const gemm_args_t part = sub_problem(args, r0, c0, MIN(g->tile_rows, args->n - r0),
+                                         (args->B_packed == NULL) ? MIN(g->blocking->nc, args->k - c0) : args->k);
+    driver(g->kernel, g->blocking, &part);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C splitting C into a 2D grid of macro-tiles, GEMM_TASKS_PER_THREAD
+ * per thread, so that threads which finish early steal the remaining tiles. Among the grids with that many
+ * tiles the one with the smallest tile perimeter is chosen, as it minimizes the packed data per tile.
+ * Pre-packed B is split only by rows, its blocks cover all columns.
+ * Problems below gemm_get_parallel_threshold() run on the calling thread, larger ones on at most
+ * max_threads threads.
+ */
+static void parallel_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                            const size_t max_threads)
+{
+    split_driver(kernel, blocking, args, max_threads, driver);
+}
+
+/**
+ * Splits C between the threads as parallel_driver does, the macro-tiles are computed by `serial`.
+ */
+static void split_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                         const size_t max_threads, serial_driver_t serial)
+{
+    const size_t row_units = (args->n + kernel->mr - 1) / kernel->mr;
+    const size_t col_units = (args->B_packed == NULL) ? ((args->k + kernel->nr - 1) / kernel->nr) : 1;
+    const size_t work = args->n * args->m * args->k;
+    const size_t threads = (work < gemm_get_parallel_threshold()) ? 1 : MAX(MIN(max_threads, gemm_get_num_threads()), 1);
+
+    size_t row_tiles = 1;
+    size_t col_tiles = 1;
+    for (size_t tiles = (threads > 1) ? threads * GEMM_TASKS_PER_THREAD : 1; tiles > 1; tiles--) {
+        size_t best_perimeter = SIZE_MAX;
+        for (size_t rows = 1; rows <= tiles; rows++) {
+            const size_t cols = tiles / rows;
+            if (((tiles % rows) != 0) || (rows > row_units) || (cols > col_units)) {
+                continue;
+            }
+            const size_t perimeter = ((row_units + rows - 1) / rows) * kernel->mr
+                                   + ((col_units + cols - 1) / cols) * kernel->nr;
+            if (perimeter < best_perimeter) {
+                best_perimeter = perimeter;
+                row_tiles = rows;
+                col_tiles = cols;
+            }
+        }
+        if (best_perimeter != SIZE_MAX) {
+            break;
+        }
+    }
+
+    if (row_tiles * col_tiles == 1) {
+        serial(kernel, blocking, args);
+        return;
+    }
+
+    parallel_gemm_t g = {
+        .kernel = kernel,
+        .blocking = blocking,
+        .args = args,
+        .serial = serial,
+        .row_tiles = row_tiles,
+        .col_tiles = col_tiles,
+    };
+    gemm_parallel_for_threads(row_tiles * col_tiles, threads, parallel_task, &g);
+}
+
+/**
+ * Blocked GEMM of one problem with packing buffers large enough for it.
+ * B is packed block by block unless args->B_packed holds all blocks packed in advance.
+ */
+static void blocked(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                    float *Ap, float *Bp)
+{
+    const size_t n = args->n;
+    const size_t m = args->m;
+    const size_t k = args->k;
+    const float *A = args->A;
+    const float *B = args->B;
+    float *C = args->C;
+    const size_t ldc = args->ldc;
+
+    if ((n == 0) || (k == 0)) {
+        return;
+    }
+    if ((m == 0) || (args->alpha == 0.0f)) {
+        scale_c(n, k, args->beta, C, ldc);
+        gemm_tile_epilogue_t ep;
+        if (block_epilogue(args, 0, 0, &ep) != NULL) {
+            gemm_epilogue_store(&ep, n, k, C, ldc, C, ldc);
+        }
+        return;
+    }
+
+    const float *B_block = args->B_packed;
+    for (size_t jc = 0; jc < k; jc += blocking->nc) { /* Loop over the NC-wide column blocks of B and C */
+        const size_t nc = MIN(blocking->nc, k - jc);
+        for (size_t pc = 0; pc < m; pc += blocking->kc) { /* Loop over the KC-deep rank updates */
+            const size_t kc = MIN(blocking->kc, m - pc);
+            if (args->B_packed == NULL) {
+                gemm_pack_b_block(kernel, kc, nc, &B[(pc * args->rs_b) + (jc * args->cs_b)],
+                                  args->rs_b, args->cs_b, Bp);
+                B_block = Bp;
+            }
+            for (size_t ic = 0; ic < n; ic += blocking->mc) { /* Loop over the MC-high row blocks of A and C */
+                const size_t mc = MIN(blocking->mc, n - ic);
+                float *C_block = &C[(ic * ldc) + jc];
+                if (pc == 0) {
+                    // The block of C is scaled right before its first update, while it is in cache.
+                    scale_c(mc, nc, args->beta, C_block, ldc);
+                }
+                gemm_pack_a_block(kernel, mc, kc, args->alpha, &A[(ic * args->rs_a) + (pc * args->cs_a)],
+                                  args->rs_a, args->cs_a, Ap);
+                // The epilogue is fused into the last rank update of the block.
+                gemm_tile_epilogue_t ep;
+                const gemm_tile_epilogue_t *epilogue = (pc + kc == m) ? block_epilogue(args, ic, jc, &ep) : NULL;
+                macro_kernel(kernel, mc, kc, nc, Ap, B_block, C_block, ldc, epilogue);
+            }
+            if (args->B_packed != NULL) {
+                B_block += gemm_pack_b_size(kernel, kc, nc);
+            }
+        }
+    }
+}
+
+/**
+ * Unpacked scalar GEMM, used when the packing buffers cannot be allocated.
+ * Needs the original B, which problems with only the pre-packed one do not have.
+ */
+static void unpacked(const gemm_args_t *args)
+{
+    if (args->B == NULL) {
+        return;
+    }
+    scale_c(args->n, args->k, args->beta, args->C, args->ldc);
+    for (size_t i = 0; i < args->n; i++) {
+        for (size_t j = 0; j < args->k; j++) {
+            for (size_t p = 0; p < args->m; p++) {
+                args->C[(i * args->ldc) + j] += args->alpha * args->A[(i * args->rs_a) + (p * args->cs_a)]
+                                                            * args->B[(p * args->rs_b) + (j * args->cs_b)];
+            }
+        }
+    }
+    gemm_tile_epilogue_t ep;
+    if (block_epilogue(args, 0, 0, &ep) != NULL) {
+        gemm_epilogue_store(&ep, args->n, args->k, args->C, args->ldc, args->C, args->ldc);
+    }
+}
+
+/**
+ * Runs several problems on the calling thread. The packing buffers are allocated and
+ * the kernel is set up once for all of them.
+ */
+static void serial_batch(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                         const gemm_args_t *args, const size_t count)
+{
+    // Buffers are sized for the whole block even if the matrices are smaller,
+    // except for dimensions which fit in one block.
+    size_t max_mc = 0;
+    size_t max_kc = 0;
+    size_t max_nc = 0;
+    int pack_b = 0;
+    for (size_t i = 0; i < count; i++) {
+        max_mc = MAX(max_mc, MIN(blocking->mc, args[i].n));
+        max_kc = MAX(max_kc, MIN(blocking->kc, args[i].m));
+        max_nc = MAX(max_nc, MIN(blocking->nc, args[i].k));
+        pack_b |= (args[i].B_packed == NULL);
+    }
+
+    float *Ap = alloc_pack_buffer(gemm_pack_a_size(kernel, max_mc, max_kc));
+    float *Bp = pack_b ? alloc_pack_buffer(gemm_pack_b_size(kernel, max_kc, max_nc)) : NULL;
+    if ((Ap == NULL) || (pack_b && (Bp == NULL))) {
+        free(Ap);
+        free(Bp);
+        // Out of memory: fall back to the unpacked scalar loop.
+        for (size_t i = 0; i < count; i++) {
+            unpacked(&args[i]);
+        }
+        return;
+    }
+
+    if (kernel->setup != NULL) {
+        kernel->setup();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        blocked(kernel, blocking, &args[i], Ap, Bp);
+    }
+
+    free(Ap);
+    free(Bp);
+}
+
+/**
+ * Blocked GEMM of one problem on the calling thread.
+ */
+static void driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args)
+{
+    serial_batch(kernel, blocking, args, 1);
+}
+
+/**
+ * Operands of the product of columns p0 .. p0 + len - 1 of A and the same rows of B, accumulated to C.
+ * beta is only applied by the first part along m and the epilogue only by the last one.
+ */
+static gemm_args_t depth_part(const gemm_args_t *args, const size_t p0, const size_t len)
+{
+    gemm_args_t part = *args;
+    part.m = len;
+    part.A = &args->A[p0 * args->cs_a];
+    part.B = &args->B[p0 * args->rs_b];
+    if (p0 != 0) {
+        part.beta = 1.0f;
+    }
+    if (p0 + len != args->m) {
+        part.row_bias = NULL;
+        part.col_bias = NULL;
+        part.activation = GEMM_ACTIVATION_NONE;
+    }
+    return part;
+}
+
+/**
+ * First half of a dimension of `size` elements, a multiple of `unit` unless the unit is too large to split it.
+ */
+static size_t half_point(const size_t size, const size_t unit) {
+    const size_t half = ROUND_UP((size + 1) / 2, unit);
+    return (half < size) ? half : (size + 1) / 2;
+}
+
+/**
+ * Recursive GEMM of one problem with packing buffers for a leaf.
+ */
+static void recursive(const gemm_kernel_t *kernel, const gemm_args_t *args, float *Ap, float *Bp)
+{
+    const size_t n = args->n;
+    const size_t m = args->m;
+    const size_t k = args->k;
+
+    if ((n <= GEMM_RECURSIVE_LEAF) && (m <= GEMM_RECURSIVE_LEAF) && (k <= GEMM_RECURSIVE_LEAF)) {
+        scale_c(n, k, args->beta, args->C, args->ldc);
+        gemm_pack_a_block(kernel, n, m, args->alpha, args->A, args->rs_a, args->cs_a, Ap);
+        gemm_pack_b_block(kernel, m, k, args->B, args->rs_b, args->cs_b, Bp);
+        gemm_tile_epilogue_t ep;
+        macro_kernel(kernel, n, m, k, Ap, Bp, args->C, args->ldc, block_epilogue(args, 0, 0, &ep));
+        return;
+    }
+
+    if ((n >= m) && (n >= k)) {
+        const size_t half = half_point(n, kernel->mr);
+        const gemm_args_t top = sub_problem(args, 0, 0, half, k);
+        const gemm_args_t bottom = sub_problem(args, half, 0, n - half, k);
+        recursive(kernel, &top, Ap, Bp);
+        recursive(kernel, &bottom, Ap, Bp);
+    } else if (k >= m) {
+        const size_t half = half_point(k, kernel->nr);
+        const gemm_args_t left = sub_problem(args, 0, 0, n, half);
+        const gemm_args_t right = sub_problem(args, 0, half, n, k - half);
+        recursive(kernel, &left, Ap, Bp);
+        recursive(kernel, &right, Ap, Bp);
+    } else {
+        const size_t half = half_point(m, MAX(kernel->kr, 4));
+        const gemm_args_t first = depth_part(args, 0, half);
+        const gemm_args_t second = depth_part(args, half, m - half);
+        recursive(kernel, &first, Ap, Bp);
+        recursive(kernel, &second, Ap, Bp);
+    }
+}
+
+/**
+ * Recursive GEMM of one problem on the calling thread, the blocking is only used by the fallbacks.
+ */
+static void recursive_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args)
+{
+    if ((args->n == 0) || (args->k == 0) || (args->m == 0) || (args->alpha == 0.0f)) {
+        blocked(kernel, blocking, args, NULL, NULL);
+        return;
+    }
+
+    float *Ap = alloc_pack_buffer(gemm_pack_a_size(kernel, GEMM_RECURSIVE_LEAF, GEMM_RECURSIVE_LEAF));
+    float *Bp = alloc_pack_buffer(gemm_pack_b_size(kernel, GEMM_RECURSIVE_LEAF, GEMM_RECURSIVE_LEAF));
+    if ((Ap == NULL) || (Bp == NULL)) {
+        free(Ap);
+        free(Bp);
+        unpacked(args);
+        return;
+    }
+
+    if (kernel->setup != NULL) {
+        kernel->setup();
+    }
+    recursive(kernel, args, Ap, Bp);
+
+    free(Ap);
+    free(Bp);
+}
+
+/**
+ * Computes C(mc x nc) += A(mc x kc) * B(kc x nc) from packed blocks, one micro tile at a time.
+ * The B micro-panel is the outer loop, so it stays in L1 while the A micro-panels stream from L2.
+ * The epilogue of the block, if any, is passed to every micro tile.
+ */
+static void macro_kernel(const gemm_kernel_t *kernel, const size_t mc, const size_t kc, const size_t nc,
+                         const float *Ap, const float *Bp, float *C, const size_t ldc,
+                         const gemm_tile_epilogue_t *epilogue)
+{
+    const size_t kc_pad = ROUND_UP(kc, kernel->kr);
+
+    for (size_t jr = 0; jr < nc; jr += kernel->nr) { /* Loop over the B micro-panels */
+        const size_t nr = MIN(kernel->nr, nc - jr);
+        const float *Bp_panel = &Bp[jr * kc_pad];
+        for (size_t ir = 0; ir < mc; ir += kernel->mr) { /* Loop over the A micro-panels */
+            const size_t mr = MIN(kernel->mr, mc - ir);
+            gemm_tile_epilogue_t ep;
+            kernel->micro_kernel(kc_pad, &Ap[ir * kc_pad], Bp_panel, &C[(ir * ldc) + jr], ldc, mr, nr,
+                                 gemm_tile_epilogue_at(epilogue, ir, jr, &ep));
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#include "gemm_kernel.h"
+
+#include <math.h>
+
+/**
+ * GELU with the tanh approximation.
+ */
+static inline float gelu(const float x) {
+    const float sqrt_2_over_pi = 0.7978845608f;
+    return 0.5f * x * (1.0f + tanhf(sqrt_2_over_pi * (x + (0.044715f * x * x * x))));
+}
+
+static inline float activate(const gemm_activation_t activation, const float x) {
+    switch (activation) {
+    case GEMM_ACTIVATION_RELU:
+        return (x > 0.0f) ? x : 0.0f;
+    case GEMM_ACTIVATION_GELU:
+        return gelu(x);
+    default:
+        return x;
+    }
+}
+
+/**
+ * Stores a rows x cols tile with the epilogue applied: C[i][j] = act(src[i][j] + col_bias[j] + row_bias[i]).
+ * src may be C itself.
+ *
+ * @param epilogue Epilogue of the tile.
+ * @param rows Number of rows of the tile.
+ * @param cols Number of columns of the tile.
+ * @param src Pointer to the accumulated tile.
+ * @param lds Leading dimension of src.
+ * @param C Pointer to the tile of C.
+ * @param ldc Leading dimension of C.
+ */
+extern void gemm_epilogue_store(const gemm_tile_epilogue_t *epilogue, const size_t rows, const size_t cols,
+                                const float *src, const size_t lds, float *C, const size_t ldc)
+{
+    for (size_t i = 0; i < rows; i++) {
+        const float row_bias = (epilogue->row_bias != NULL) ? epilogue->row_bias[i] : 0.0f;
+        for (size_t j = 0; j < cols; j++) {
+            float x = src[(i * lds) + j];
+            if (epilogue->col_bias != NULL) {
+                x += epilogue->col_bias[j];
+            }
+            C[(i * ldc) + j] = activate(epilogue->activation, x + row_bias);
+        }
+    }
+}
+
+/**
+ * Applies the activation to a rows x cols tile of C in place.
+ */
+extern void gemm_epilogue_activate(const gemm_activation_t activation, const size_t rows, const size_t cols,
+                                   float *C, const size_t ldc)
+{
+    if (activation == GEMM_ACTIVATION_NONE) {
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            C[(i * ldc) + j] = activate(activation, C[(i * ldc) + j]);
+        }
+    }
+}
+
+/**
+ * Computes C = act(alpha * A * B + beta * C + col_bias + row_bias) for row-major matrices.
+ * alpha and beta are handled by the driver as in sgemm, the rest is fused into the micro kernels.
+ */
+extern void gemm_driver_epilogue(const gemm_kernel_t *kernel, const float *A, const float *B, float *C,
+                                 const size_t n, const size_t m, const size_t k, const gemm_epilogue_t *epilogue)
+{
+    const gemm_args_t args = {
+        .n = n,
+        .m = m,
+        .k = k,
+        .alpha = (epilogue != NULL) ? epilogue->alpha : 1.0f,
+        .A = A,
+        .rs_a = m,
+        .cs_a = 1,
+        .B = B,
+        .rs_b = k,
+        .cs_b = 1,
+        .B_packed = NULL,
+        .beta = (epilogue != NULL) ? epilogue->beta : 1.0f,
+        .C = C,
+        .ldc = k,
+        .row_bias = (epilogue != NULL) ? epilogue->row_bias : NULL,
+        .col_bias = (epilogue != NULL) ? epilogue->col_bias : NULL,
+        .activation = (epilogue != NULL) ? epilogue->activation : GEMM_ACTIVATION_NONE,
+    };
+    gemm_driver_args(kernel, NULL, &args);
+}
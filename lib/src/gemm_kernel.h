@@ -0,0 +1,418 @@
+#ifndef GEMM_KERNEL_H
+#define GEMM_KERNEL_H
+
+#include "gemm.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define ROUND_UP(x, a) ((((x) + (a) - 1) / (a)) * (a))
+
+/*
+ * Default panel sizes of the blocked driver (GotoBLAS notation):
+ *   GEMM_MC - rows of A and C in a macro block, the packed A block (MC x KC) stays in L2;
+ *   GEMM_KC - depth of a rank-KC update, a packed KC x NR micro-panel of B stays in L1;
+ *   GEMM_NC - columns of B and C in a macro block, the packed B block (KC x NC) stays in L2/L3.
+ * MC and NC are multiples of the register blocks of all kernels.
+ */
+#ifndef GEMM_MC
+#define GEMM_MC 64
+#endif
+
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+
+#ifndef GEMM_NC
+#define GEMM_NC 512
+#endif
+
+// Alignment of packing buffers in bytes.
+#define GEMM_PACK_ALIGN 64
+
+/**
+ * Panel sizes of the blocked driver.
+ */
+typedef struct gemm_blocking {
+    size_t mc; /* Rows of A and C in a macro block */
+    size_t kc; /* Columns of A and rows of B in a macro block */
+    size_t nc; /* Columns of B and C in a macro block */
+} gemm_blocking_t;
+
+/**
+ * Epilogue of a tile of C: C[i][j] = act(C[i][j] + col_bias[j] + row_bias[i]).
+ * The biases point at the elements of the first row and column of the tile.
+ */
+typedef struct gemm_tile_epilogue {
+    const float *row_bias; /* NULL if none */
+    const float *col_bias; /* NULL if none */
+    gemm_activation_t activation;
+} gemm_tile_epilogue_t;
+
+/**
+ * Computes C(mr x nr) += Ap * Bp for one micro tile.
+ *
+ * @param kc Number of columns in the A micro-panel and rows in the B micro-panel (multiple of kr).
+ * @param Ap Pointer to the packed MR x kc micro-panel of A.
+ * @param Bp Pointer to the packed kc x NR micro-panel of B.
+ * @param C Pointer to the tile of C.
+ * @param ldc Leading dimension of C.
+ * @param mr Number of rows of the tile (at most MR).
+ * @param nr Number of columns of the tile (at most NR).
+ * @param epilogue Applied to the accumulators before they are stored, NULL for all but the last rank update.
+ */
+typedef void (*gemm_micro_kernel_t)(const size_t kc, const float *Ap, const float *Bp,
+                                    float *C, const size_t ldc, const size_t mr, const size_t nr,
+                                    const gemm_tile_epilogue_t *epilogue);
+
+/**
+ * Row kernel of the unpacked strategies: c[0 .. cols) += a[0 .. m) * B, where row p of B starts at B + p * ldb.
+ * Every strip of c stays in registers while the rows of B, scaled by a[p], are accumulated into it.
+ */
+typedef void (*gemm_row_kernel_t)(const size_t m, const size_t cols, const float *a, const float *B,
+                                  const size_t ldb, float *c);
+
+/**
+ * Kernel plugged into the blocked driver.
+ *
+ * A micro-panel holds MR rows of A (NR columns of B for the B micro-panel) and kc elements along K,
+ * K is split into groups of kr elements and element (r, p) of a panel of width W is stored at
+ * (p / kr) * W * kr + r * kr + p % kr:
+ *   kr = 1 - one column of the A panel (one row of the B panel) after another, as the broadcast
+ *            scalar and vector kernels consume them;
+ *   kr = 4 - 4x4 tiles one after another, as the matrix kernel loads them with mld.
+ * Panels are padded with zeros up to MR/NR rows and a multiple of kr along K.
+ */
+typedef struct gemm_kernel {
+    const char *name;
+    size_t mr; /* Rows of a micro tile of C */
+    size_t nr; /* Columns of a micro tile of C */
+    size_t kr; /* Size of the K groups in micro-panels */
+    void (*setup)(void); /* Per-call setup (e.g. matrix registers configuration), may be NULL */
+    gemm_micro_kernel_t micro_kernel;
+    int (*probe)(void); /* Returns nonzero if the hart runs the kernel, may raise SIGILL; NULL if any hart does */
+    gemm_row_kernel_t row_kernel; /* Wide rows of C in GEMM_STRATEGY_UNPACKED and GEMV, NULL for the scalar loop */
+} gemm_kernel_t;
+
+extern const gemm_blocking_t gemm_default_blocking;
+
+extern const gemm_kernel_t gemm_kernel_ref;
+extern const gemm_kernel_t gemm_kernel_rvv;
+extern const gemm_kernel_t gemm_kernel_rvv_m1;
+extern const gemm_kernel_t gemm_kernel_rvv_m2;
+extern const gemm_kernel_t gemm_kernel_rvv_m4;
+extern const gemm_kernel_t gemm_kernel_rvv_m8;
+extern const gemm_kernel_t gemm_kernel_rvm;
+
+/**
+ * Kernel of the backend selected for this hart, see gemm_set_backend.
+ */
+extern const gemm_kernel_t *gemm_dispatch_kernel(void);
+
+/**
+ * Kernel of the backend if it is built and the hart supports it, NULL otherwise.
+ */
+extern const gemm_kernel_t *gemm_backend_kernel(const gemm_backend_t backend);
+
+/**
+ * Backend named as in RMVGEMM_BACKEND (ref, rvv or rvm).
+ *
+ * @return 0 on success, -1 if the name is unknown.
+ */
+extern int gemm_backend_by_name(const char *name, gemm_backend_t *backend);
+
+/**
+ * Runs a probe which executes an instruction the hart may not implement (or may not allow in user mode).
+ *
+ * @return Result of the probe, 0 if it raised SIGILL.
+ */
+extern int gemm_run_probe(int (*probe)(void));
+
+#if defined(RV64GV) || defined(RV64GVM)
+/**
+ * Checks that the vector unit implements RVV 0.7.1 the kernels are built for: the 0.7.1 encoding
+ * of SEW = 32 means SEW = 16 in RVV 1.0, where VLMAX of e8 is only twice as large.
+ * Raises SIGILL on harts without a vector unit.
+ */
+static inline int gemm_probe_rvv_0p7(void) {
+    const size_t avl = (size_t)1 << 16;
+    return vsetvl_e8m1(avl) == 4 * vsetvl_e32m1(avl);
+}
+
+/**
+ * Row kernel of the vector and matrix backends, see gemm_row_kernel_t.
+ */
+extern void gemm_row_kernel_rvv(const size_t m, const size_t cols, const float *a, const float *B,
+                                const size_t ldb, float *c);
+#endif // RV64GV || RV64GVM
+
+// Register block of the scalar kernel.
+#define GEMM_REF_MR 4
+#define GEMM_REF_NR 4
+
+/**
+ * Scalar micro kernel, also used by the vector and matrix kernels on targets without these extensions.
+ */
+extern void gemm_micro_kernel_ref(const size_t kc, const float *Ap, const float *Bp,
+                                  float *C, const size_t ldc, const size_t mr, const size_t nr,
+                                  const gemm_tile_epilogue_t *epilogue);
+
+/**
+ * Epilogue of the sub-tile starting at row i and column j of a tile.
+ *
+ * @param epilogue Epilogue of the tile, may be NULL.
+ * @param i First row of the sub-tile.
+ * @param j First column of the sub-tile.
+ * @param sub Storage for the result.
+ * @return sub, NULL if epilogue is NULL.
+ */
+static inline const gemm_tile_epilogue_t *gemm_tile_epilogue_at(const gemm_tile_epilogue_t *epilogue,
+                                                                const size_t i, const size_t j,
+                                                                gemm_tile_epilogue_t *sub) {
+    if (epilogue == NULL) {
+        return NULL;
+    }
+    sub->row_bias = (epilogue->row_bias != NULL) ? &epilogue->row_bias[i] : NULL;
+    sub->col_bias = (epilogue->col_bias != NULL) ? &epilogue->col_bias[j] : NULL;
+    sub->activation = epilogue->activation;
+    return sub;
+}
+
+/**
+ * Stores a rows x cols tile with the epilogue applied: C[i][j] = act(src[i][j] + col_bias[j] + row_bias[i]).
+ * src may be C itself.
+ *
+ * @param epilogue Epilogue of the tile.
+ * @param rows Number of rows of the tile.
+ * @param cols Number of columns of the tile.
+ * @param src Pointer to the accumulated tile.
+ * @param lds Leading dimension of src.
+ * @param C Pointer to the tile of C.
+ * @param ldc Leading dimension of C.
+ */
+extern void gemm_epilogue_store(const gemm_tile_epilogue_t *epilogue, const size_t rows, const size_t cols,
+                                const float *src, const size_t lds, float *C, const size_t ldc);
+
+/**
+ * Applies the activation to a rows x cols tile of C in place.
+ */
+extern void gemm_epilogue_activate(const gemm_activation_t activation, const size_t rows, const size_t cols,
+                                   float *C, const size_t ldc);
+
+/**
+ * Packs an mc x kc block of A into micro-panels of kernel->mr rows.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param mc Number of rows in the block.
+ * @param kc Number of columns in the block.
+ * @param alpha Factor applied to the packed elements.
+ * @param A Pointer to the block of A.
+ * @param rs Distance between rows of A (lda for a row-major A, 1 for a transposed one).
+ * @param cs Distance between columns of A.
+ * @param Ap Destination, gemm_pack_a_size(kernel, mc, kc) floats.
+ */
+extern void gemm_pack_a_block(const gemm_kernel_t *kernel, const size_t mc, const size_t kc, const float alpha,
+                              const float *A, const size_t rs, const size_t cs, float *Ap);
+
+/**
+ * Packs a kc x nc block of B into micro-panels of kernel->nr columns.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param kc Number of rows in the block.
+ * @param nc Number of columns in the block.
+ * @param B Pointer to the block of B.
+ * @param rs Distance between rows of B (ldb for a row-major B, 1 for a transposed one).
+ * @param cs Distance between columns of B.
+ * @param Bp Destination, gemm_pack_b_size(kernel, kc, nc) floats.
+ */
+extern void gemm_pack_b_block(const gemm_kernel_t *kernel, const size_t kc, const size_t nc,
+                              const float *B, const size_t rs, const size_t cs, float *Bp);
+
+/**
+ * Number of floats of a packed mc x kc block of A.
+ */
+static inline size_t gemm_pack_a_size(const gemm_kernel_t *kernel, const size_t mc, const size_t kc) {
+    return ROUND_UP(mc, kernel->mr) * ROUND_UP(kc, kernel->kr);
+}
+
+/**
+ * Number of floats of a packed kc x nc block of B.
+ */
+static inline size_t gemm_pack_b_size(const gemm_kernel_t *kernel, const size_t kc, const size_t nc) {
+    return ROUND_UP(nc, kernel->nr) * ROUND_UP(kc, kernel->kr);
+}
+
+/**
+ * Operands of one product C = alpha * A * B + beta * C.
+ * Element (i, p) of A is A[i * rs_a + p * cs_a] and element (p, j) of B is B[p * rs_b + j * cs_b],
+ * so transposed operands are described by swapped strides and never copied.
+ */
+typedef struct gemm_args {
+    size_t n; /* Rows of A and C */
+    size_t m; /* Columns of A and rows of B */
+    size_t k; /* Columns of B and C */
+    float alpha;
+    const float *A;
+    size_t rs_a;
+    size_t cs_a;
+    const float *B;
+    size_t rs_b;
+    size_t cs_b;
+    const float *B_packed; /* All blocks of B packed with gemm_pack_b_blocks, B is not used if set */
+    float beta; /* 0 overwrites C without reading it */
+    float *C;
+    size_t ldc;
+    const float *row_bias; /* n elements added to the rows of C after the product, may be NULL */
+    const float *col_bias; /* k elements added to the columns of C after the product, may be NULL */
+    gemm_activation_t activation; /* Applied after the biases */
+} gemm_args_t;
+
+/**
+ * Computes C += A * B splitting the matrices into MC x KC blocks of A and KC x NC blocks of B.
+ * Every block is packed into micro-panels and multiplied by the micro kernel tile by tile.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param A Pointer to the first matrix (size n x m).
+ * @param lda Leading dimension of A.
+ * @param B Pointer to the second matrix (size m x k).
+ * @param ldb Leading dimension of B.
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param ldc Leading dimension of C.
+ * @param n Number of rows in matrix A and resulting matrix C.
+ * @param m Number of columns in matrix A and number of rows in matrix B.
+ * @param k Number of columns in matrix B and resulting matrix C.
+ */
+extern void gemm_driver(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                        const float *A, const size_t lda, const float *B, const size_t ldb, float *C, const size_t ldc,
+                        const size_t n, const size_t m, const size_t k);
+
+/**
+ * Computes C = alpha * A * B + beta * C with the blocked driver.
+ * alpha is applied while A is packed and beta to every block of C before its first update.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands.
+ */
+extern void gemm_driver_args(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args);
+
+/**
+ * gemm_driver_args on at most `threads` threads.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands.
+ * @param threads Upper bound of the number of threads, values above gemm_get_num_threads() do not add threads.
+ */
+extern void gemm_driver_threads(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking, const gemm_args_t *args,
+                                const size_t threads);
+
+/**
+ * Computes C = alpha * A * B + beta * C with the cache-oblivious recursive driver: the largest of n, m and k
+ * is halved until the leaf is small enough to be packed and multiplied by the micro kernel, so no panel sizes are needed.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param args Operands, B must not be pre-packed.
+ * @param threads Upper bound of the number of threads, values above gemm_get_num_threads() do not add threads.
+ */
+extern void gemm_driver_recursive(const gemm_kernel_t *kernel, const gemm_args_t *args, const size_t threads);
+
+/**
+ * Computes C = alpha * A * B + beta * C for several independent problems.
+ * Problems too small to be split between threads are distributed between threads as a whole,
+ * contiguous runs of them share the packing buffers and the kernel setup.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands of every problem.
+ * @param count Number of problems.
+ */
+extern void gemm_driver_batch(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                              const gemm_args_t *args, const size_t count);
+
+/**
+ * Computes C = alpha * A * B + beta * C for problems of different shapes.
+ * All problems are cut into macro-tiles of the same size which are scheduled on the thread pool
+ * together, so small problems run alongside large ones instead of one after another.
+ *
+ * @param kernel Kernel used for micro tiles.
+ * @param blocking Panel sizes, gemm_default_blocking if NULL.
+ * @param args Operands of every problem.
+ * @param count Number of problems.
+ */
+extern void gemm_driver_grouped(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                                const gemm_args_t *args, const size_t count);
+
+/**
+ * Checks the parameters of sgemm before anything is computed.
+ *
+ * @return 0 if they are valid, otherwise the number of the first invalid parameter, see sgemm in gemm.h.
+ */
+extern int gemm_sgemm_check(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                            const size_t M, const size_t N, const size_t K,
+                            const size_t lda, const size_t ldb, const size_t ldc);
+
+/**
+ * sgemm with the given kernel and valid parameters, see sgemm in gemm.h.
+ */
+extern void gemm_sgemm(const gemm_kernel_t *kernel,
+                       const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                       const size_t M, const size_t N, const size_t K, const float alpha,
+                       const float *A, const size_t lda, const float *B, const size_t ldb,
+                       const float beta, float *C, const size_t ldc);
+
+/**
+ * gemm_block4x4_*_epilogue with the given kernel, see gemm_block4x4_rvm_epilogue in gemm.h.
+ */
+extern void gemm_driver_epilogue(const gemm_kernel_t *kernel, const float *A, const float *B, float *C,
+                                 const size_t n, const size_t m, const size_t k, const gemm_epilogue_t *epilogue);
+
+/**
+ * Matrix B packed in advance for one kernel and blocking.
+ * Blocks of B are stored one after another in the order the driver consumes them.
+ */
+struct gemm_packed_b {
+    const gemm_kernel_t *kernel;
+    gemm_blocking_t blocking;
+    size_t m; /* Rows of B */
+    size_t k; /* Columns of B */
+    float *data; /* Packed blocks, GEMM_PACK_ALIGN aligned */
+    void *allocation; /* Memory to free, NULL if the buffer belongs to the caller */
+};
+
+/**
+ * Packs the whole matrix B block by block in the order the driver consumes them.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param blocking Panel sizes.
+ * @param B Pointer to the matrix (size m x k).
+ * @param rs Distance between rows of B.
+ * @param cs Distance between columns of B.
+ * @param m Number of rows in B.
+ * @param k Number of columns in B.
+ * @param Bp Destination, gemm_pack_b_blocks_size(kernel, blocking, m, k) floats.
+ */
+extern void gemm_pack_b_blocks(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                               const float *B, const size_t rs, const size_t cs, const size_t m, const size_t k,
+                               float *Bp);
+
+/**
+ * Number of floats of the whole matrix B packed with gemm_pack_b_blocks.
+ */
+extern size_t gemm_pack_b_blocks_size(const gemm_kernel_t *kernel, const gemm_blocking_t *blocking,
+                                      const size_t m, const size_t k);
+
+/**
+ * Computes C += A * B for B packed in advance, only the blocks of A are packed.
+ *
+ * @param packed Packed matrix B (size m x k).
+ * @param A Pointer to the first matrix (size n x m).
+ * @param lda Leading dimension of A.
+ * @param C Pointer to the resulting matrix (size n x k).
+ * @param ldc Leading dimension of C.
+ * @param n Number of rows in matrix A and resulting matrix C.
+ */
+extern void gemm_driver_prepacked(const gemm_packed_b *packed, const float *A, const size_t lda,
+                                  float *C, const size_t ldc, const size_t n);
+
+#endif // GEMM_KERNEL_H
@@ -0,0 +1,87 @@
+#include "gemm_kernel.h"
+
+#include <string.h>
+
+static void pack_panels(const size_t rows, const size_t kc, const float alpha,
+                        const float *src, const size_t rs, const size_t cs,
+                        const size_t width, const size_t kr, float *dst);
+
+/**
+ * Packs an mc x kc block of A into micro-panels of kernel->mr rows.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param mc Number of rows in the block.
+ * @param kc Number of columns in the block.
+ * @param alpha Factor applied to the packed elements.
+ * @param A Pointer to the block of A.
+ * @param rs Distance between rows of A (lda for a row-major A, 1 for a transposed one).
+ * @param cs Distance between columns of A.
+ * @param Ap Destination, gemm_pack_a_size(kernel, mc, kc) floats.
+ */
+extern void gemm_pack_a_block(const gemm_kernel_t *kernel, const size_t mc, const size_t kc, const float alpha,
+                              const float *A, const size_t rs, const size_t cs, float *Ap)
+{
+    pack_panels(mc, kc, alpha, A, rs, cs, kernel->mr, kernel->kr, Ap);
+}
+
+/**
+ * Packs a kc x nc block of B into micro-panels of kernel->nr columns.
+ *
+ * @param kernel Kernel which consumes the panels.
+ * @param kc Number of rows in the block.
+ * @param nc Number of columns in the block.
+ * @param B Pointer to the block of B.
+ * @param rs Distance between rows of B (ldb for a row-major B, 1 for a transposed one).
+ * @param cs Distance between columns of B.
+ * @param Bp Destination, gemm_pack_b_size(kernel, kc, nc) floats.
+ */
+extern void gemm_pack_b_block(const gemm_kernel_t *kernel, const size_t kc, const size_t nc,
+                              const float *B, const size_t rs, const size_t cs, float *Bp)
+{
+    // A column of B is a row of its micro-panel.
+    pack_panels(nc, kc, 1.0f, B, cs, rs, kernel->nr, kernel->kr, Bp);
+}
+
+/**
+ * Packs `rows` rows of kc elements multiplied by alpha into panels of `width` rows.
+ * Element (r, p) of the source is src[r * rs + p * cs].
+ * Element (r, p) of a panel is stored at (p / kr) * width * kr + r * kr + p % kr.
+ * Missing rows of the last panel and the K tail up to a multiple of kr are filled with zeros.
+ */
+static void pack_panels(const size_t rows, const size_t kc, const float alpha,
+                        const float *src, const size_t rs, const size_t cs,
+                        const size_t width, const size_t kr, float *dst)
+{
+    const size_t kc_pad = ROUND_UP(kc, kr);
+
+    for (size_t r0 = 0; r0 < rows; r0 += width) { /* Loop over the panels */
+        const size_t panel_rows = MIN(width, rows - r0);
+        const float *panel_src = &src[r0 * rs];
+
+        if (kr == 1) {
+            for (size_t p = 0; p < kc; p += 1) {
+                for (size_t r = 0; r < panel_rows; r += 1) {
+                    dst[r] = alpha * panel_src[(r * rs) + (p * cs)];
+                }
+                for (size_t r = panel_rows; r < width; r += 1) {
+                    dst[r] = 0.0f;
+                }
+                dst += width;
+            }
+        } else {
+            for (size_t p0 = 0; p0 < kc_pad; p0 += kr) {
+                const size_t group = (p0 < kc) ? MIN(kr, kc - p0) : 0;
+                for (size_t r = 0; r < panel_rows; r += 1) {
+                    for (size_t p = 0; p < group; p += 1) {
+                        dst[(r * kr) + p] = alpha * panel_src[(r * rs) + ((p0 + p) * cs)];
+                    }
+                    for (size_t p = group; p < kr; p += 1) {
+                        dst[(r * kr) + p] = 0.0f;
+                    }
+                }
+                memset(&dst[panel_rows * kr], 0, (width - panel_rows) * kr * sizeof(float));
+                dst += width * kr;
+            }
+        }
+    }
+}
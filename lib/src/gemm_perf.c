@@ -0,0 +1,425 @@
+#include "gemm_kernel.h"
+#include "gemm_perf.h"
+
+#ifdef GEMM_PERF_COUNTERS
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Entry point and shape pairs with separate statistics, calls of further pairs are counted as dropped.
+ */
+#ifndef GEMM_PERF_SLOTS
+#define GEMM_PERF_SLOTS 256
+#endif
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} events[GEMM_PERF_EVENTS] = {
+    [GEMM_PERF_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [GEMM_PERF_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [GEMM_PERF_CACHE_MISSES] = {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    [GEMM_PERF_DTLB_MISSES] = {"dTLB-load-misses", PERF_TYPE_HW_CACHE,
+                               PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                               | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    [GEMM_PERF_STALLED_BACKEND] = {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+                                   PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+};
+
+/**
+ * Counter group of a thread. The events the PMU does not implement are not opened,
+ * slot[i] is the position of event i in the group read or -1.
+ */
+typedef struct thread_counters {
+    int leader;
+    int fds[GEMM_PERF_EVENTS];
+    int slot[GEMM_PERF_EVENTS];
+    size_t opened;
+} thread_counters_t;
+
+/**
+ * Statistics of an entry point and shape.
+ */
+typedef struct perf_stat {
+    const char *name; /* NULL for a free slot */
+    size_t n;
+    size_t m;
+    size_t k;
+    uint64_t calls;
+    uint64_t flops;
+    uint64_t time_ns;
+    uint64_t values[GEMM_PERF_EVENTS];
+    uint64_t counted[GEMM_PERF_EVENTS]; /* Calls the event was read in */
+} perf_stat_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_key_t key;
+    int rdcycle; /* Fallback cycle counter is readable */
+    pthread_mutex_t lock;
+    perf_stat_t stats[GEMM_PERF_SLOTS];
+    uint64_t dropped;
+} perf = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static __thread thread_counters_t *counters;
+static __thread gemm_perf_scope_t *current;
+
+static uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+#if defined(__riscv)
+static uint64_t read_rdcycle(void) {
+    uint64_t value;
+    __asm__ volatile("rdcycle %0" : "=r"(value));
+    return value;
+}
+
+static int probe_rdcycle(void) {
+    (void)read_rdcycle();
+    return 1;
+}
+#endif
+
+static void close_counters(void *arg) {
+    thread_counters_t *c = arg;
+    for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+        if (c->fds[i] >= 0) {
+            close(c->fds[i]);
+        }
+    }
+    free(c);
+}
+
+static void init(void) {
+    pthread_key_create(&perf.key, close_counters);
+#if defined(__riscv)
+    // Linux may deny user access to the cycle CSR, then rdcycle raises SIGILL
+    perf.rdcycle = gemm_run_probe(probe_rdcycle);
+#endif
+}
+
+static int open_event(const size_t event, const int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[event].type;
+    attr.config = events[event].config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/**
+ * Opens the counter group of the calling thread on its first call. Without the perf_event syscall
+ * (no PMU driver, perf_event_paranoid, QEMU user mode) the group stays empty and rdcycle is used.
+ */
+static thread_counters_t *thread_counters(void) {
+    if (counters != NULL) {
+        return counters;
+    }
+    pthread_once(&perf.once, init);
+
+    thread_counters_t *c = malloc(sizeof(*c));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->leader = -1;
+    c->opened = 0;
+    for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+        c->fds[i] = open_event(i, c->leader);
+        c->slot[i] = -1;
+        if (c->fds[i] >= 0) {
+            if (c->leader < 0) {
+                c->leader = c->fds[i];
+            }
+            c->slot[i] = (int)c->opened++;
+        }
+    }
+    pthread_setspecific(perf.key, c);
+    counters = c;
+    return c;
+}
+
+static void read_counters(gemm_perf_sample_t *sample) {
+    sample->valid = 0;
+    sample->group = 0;
+    sample->enabled = 0;
+    sample->running = 0;
+    sample->time_ns = clock_ns();
+
+    const thread_counters_t *c = thread_counters();
+    if ((c != NULL) && (c->opened > 0)) {
+        // Group read: number of events, time enabled, time running, then the values in the order of opening
+        uint64_t values[3 + GEMM_PERF_EVENTS];
+        sample->group = 1;
+        if (read(c->leader, values, sizeof(values)) > 0) {
+            sample->enabled = values[1];
+            sample->running = values[2];
+            for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+                if (c->slot[i] >= 0) {
+                    sample->values[i] = values[3 + c->slot[i]];
+                    sample->valid |= 1u << i;
+                }
+            }
+        }
+        return;
+    }
+
+#if defined(__riscv)
+    if (perf.rdcycle) {
+        sample->values[GEMM_PERF_CYCLES] = read_rdcycle();
+        sample->valid |= 1u << GEMM_PERF_CYCLES;
+    }
+#endif
+}
+
+/**
+ * Events of a thread between two samples. When the PMU has fewer counters than the group needs, the kernel
+ * multiplexes the groups and the counts are scaled up by the share of the time the group was counting;
+ * a group which was not counting at all gives no events.
+ *
+ * @return Bit mask of the events stored in deltas.
+ */
+static unsigned sample_delta(const gemm_perf_sample_t *begin, const gemm_perf_sample_t *end, uint64_t *deltas) {
+    const unsigned valid = begin->valid & end->valid;
+    double scale = 1.0;
+    if (begin->group) {
+        const uint64_t running = end->running - begin->running;
+        if (running == 0) {
+            return 0;
+        }
+        scale = (double)(end->enabled - begin->enabled) / (double)running;
+    }
+    for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+        if (valid & (1u << i)) {
+            deltas[i] = (uint64_t)(((double)(end->values[i] - begin->values[i]) * scale) + 0.5);
+        }
+    }
+    return valid;
+}
+
+static size_t slot_hash(const char *name, const size_t n, const size_t m, const size_t k) {
+    size_t hash = (size_t)(uintptr_t)name;
+    hash = (hash * 31) + n;
+    hash = (hash * 31) + m;
+    hash = (hash * 31) + k;
+    return hash ^ (hash >> 17);
+}
+
+extern void gemm_perf_begin(gemm_perf_scope_t *scope, const char *name, const size_t n, const size_t m, const size_t k,
+                            const uint64_t flops)
+{
+    scope->name = name;
+    scope->n = n;
+    scope->m = m;
+    scope->k = k;
+    scope->flops = flops;
+    scope->outer = current;
+    memset(scope->workers, 0, sizeof(scope->workers));
+    scope->workers_missing = 0;
+    current = scope;
+    read_counters(&scope->start);
+}
+
+extern void gemm_perf_end(gemm_perf_scope_t *scope)
+{
+    gemm_perf_sample_t end;
+    read_counters(&end);
+    uint64_t deltas[GEMM_PERF_EVENTS];
+    const unsigned valid = sample_delta(&scope->start, &end, deltas) & ~scope->workers_missing;
+    current = scope->outer;
+
+    pthread_mutex_lock(&perf.lock);
+    if (scope->outer != NULL) {
+        // The events of the calling thread are also counted by the outer call, the ones of the workers are not
+        for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+            scope->outer->workers[i] += scope->workers[i];
+        }
+        scope->outer->workers_missing |= scope->workers_missing;
+    }
+
+    const size_t start = slot_hash(scope->name, scope->n, scope->m, scope->k) % GEMM_PERF_SLOTS;
+    perf_stat_t *stat = NULL;
+    for (size_t probe = 0; probe < GEMM_PERF_SLOTS; probe++) {
+        perf_stat_t *slot = &perf.stats[(start + probe) % GEMM_PERF_SLOTS];
+        if (slot->name == NULL) {
+            slot->name = scope->name;
+            slot->n = scope->n;
+            slot->m = scope->m;
+            slot->k = scope->k;
+        }
+        if ((slot->name == scope->name) && (slot->n == scope->n) && (slot->m == scope->m) && (slot->k == scope->k)) {
+            stat = slot;
+            break;
+        }
+    }
+
+    if (stat == NULL) {
+        perf.dropped++;
+    } else {
+        stat->calls++;
+        stat->flops += scope->flops;
+        stat->time_ns += end.time_ns - scope->start.time_ns;
+        for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+            if (valid & (1u << i)) {
+                stat->values[i] += deltas[i] + scope->workers[i];
+                stat->counted[i]++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&perf.lock);
+}
+
+extern gemm_perf_scope_t *gemm_perf_current(void)
+{
+    return current;
+}
+
+extern void gemm_perf_worker_begin(gemm_perf_worker_t *worker, gemm_perf_scope_t *scope)
+{
+    worker->scope = scope;
+    if (scope != NULL) {
+        read_counters(&worker->start);
+    }
+}
+
+extern void gemm_perf_worker_end(const gemm_perf_worker_t *worker)
+{
+    if (worker->scope == NULL) {
+        return;
+    }
+    gemm_perf_sample_t end;
+    read_counters(&end);
+    uint64_t deltas[GEMM_PERF_EVENTS];
+    const unsigned valid = sample_delta(&worker->start, &end, deltas);
+
+    // The calling thread reads the sums only after all workers have finished the loop
+    pthread_mutex_lock(&perf.lock);
+    for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+        if (valid & (1u << i)) {
+            worker->scope->workers[i] += deltas[i];
+        } else {
+            worker->scope->workers_missing |= 1u << i;
+        }
+    }
+    pthread_mutex_unlock(&perf.lock);
+}
+
+/**
+ * Average of an event per call of the statistics, -1 if the event was never read.
+ */
+static double per_call(const perf_stat_t *stat, const size_t event) {
+    return (stat->counted[event] != 0) ? (double)stat->values[event] / (double)stat->counted[event] : -1.0;
+}
+
+extern int gemm_perf_dump(FILE *stream)
+{
+    const thread_counters_t *c = thread_counters();
+    fprintf(stream, "# counters:");
+    if ((c != NULL) && (c->opened > 0)) {
+        for (size_t i = 0; i < GEMM_PERF_EVENTS; i++) {
+            if (c->slot[i] >= 0) {
+                fprintf(stream, " %s", events[i].name);
+            }
+        }
+        fprintf(stream, " (perf_event, calling thread and pool workers)\n");
+    } else {
+        fprintf(stream, perf.rdcycle ? " cycles (rdcycle, calling thread and pool workers)\n" : " time only\n");
+    }
+    fprintf(stream, "%-28s %6s %6s %6s %8s %12s %14s %6s %14s %14s %8s\n", "entry", "n", "m", "k", "calls",
+            "time, us", "cycles", "IPC", "cache-miss/kF", "dTLB-miss/kF", "stall %");
+
+    pthread_mutex_lock(&perf.lock);
+    for (size_t s = 0; s < GEMM_PERF_SLOTS; s++) {
+        const perf_stat_t *stat = &perf.stats[s];
+        if (stat->calls == 0) {
+            continue;
+        }
+        // Per call averages, misses per thousand FLOPs, -1 where the event is not available
+        const double kflops = (double)stat->flops / (double)stat->calls * 1e-3;
+        const double cycles = per_call(stat, GEMM_PERF_CYCLES);
+        const double instructions = per_call(stat, GEMM_PERF_INSTRUCTIONS);
+        const double cache_misses = per_call(stat, GEMM_PERF_CACHE_MISSES);
+        const double dtlb_misses = per_call(stat, GEMM_PERF_DTLB_MISSES);
+        const double stalled = per_call(stat, GEMM_PERF_STALLED_BACKEND);
+        fprintf(stream, "%-28s %6zu %6zu %6zu %8llu %12.3f %14.0f %6.2f %14.3f %14.3f %8.1f\n",
+                stat->name, stat->n, stat->m, stat->k, (unsigned long long)stat->calls,
+                (double)stat->time_ns / (double)stat->calls * 1e-3, cycles,
+                ((cycles > 0) && (instructions >= 0)) ? instructions / cycles : -1.0,
+                ((kflops > 0) && (cache_misses >= 0)) ? cache_misses / kflops : -1.0,
+                ((kflops > 0) && (dtlb_misses >= 0)) ? dtlb_misses / kflops : -1.0,
+                ((cycles > 0) && (stalled >= 0)) ? 100.0 * stalled / cycles : -1.0);
+    }
+    if (perf.dropped != 0) {
+        fprintf(stream, "# %llu calls of further shapes are not counted\n", (unsigned long long)perf.dropped);
+    }
+    pthread_mutex_unlock(&perf.lock);
+    return 0;
+}
+
+extern size_t gemm_perf_get_stats(gemm_perf_entry_t *entries, const size_t capacity)
+{
+    size_t count = 0;
+    pthread_mutex_lock(&perf.lock);
+    for (size_t s = 0; s < GEMM_PERF_SLOTS; s++) {
+        const perf_stat_t *stat = &perf.stats[s];
+        if (stat->calls == 0) {
+            continue;
+        }
+        if (count < capacity) {
+            gemm_perf_entry_t *entry = &entries[count];
+            entry->entry = stat->name;
+            entry->n = stat->n;
+            entry->m = stat->m;
+            entry->k = stat->k;
+            entry->calls = stat->calls;
+            entry->flops = stat->flops;
+            entry->time_ns = stat->time_ns;
+        }
+        count++;
+    }
+    pthread_mutex_unlock(&perf.lock);
+    return count;
+}
+
+extern void gemm_perf_reset(void)
+{
+    pthread_mutex_lock(&perf.lock);
+    memset(perf.stats, 0, sizeof(perf.stats));
+    perf.dropped = 0;
+    pthread_mutex_unlock(&perf.lock);
+}
+
+#else
+
+extern int gemm_perf_dump(FILE *stream)
+{
+    (void)stream;
+    return -1;
+}
+
+extern size_t gemm_perf_get_stats(gemm_perf_entry_t *entries, const size_t capacity)
+{
+    (void)entries;
+    (void)capacity;
+    return 0;
+}
+
+extern void gemm_perf_reset(void)
+{
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef GEMM_PERF_H
+#define GEMM_PERF_H
+
+#include "gemm.h"
+
+#ifdef GEMM_PERF_COUNTERS
+/*
+ * Hardware events counted around the gemm entry points (ENABLE_PERF_COUNTERS=ON).
+ */
+enum {
+    GEMM_PERF_CYCLES = 0,
+    GEMM_PERF_INSTRUCTIONS,
+    GEMM_PERF_CACHE_MISSES,
+    GEMM_PERF_DTLB_MISSES,
+    GEMM_PERF_STALLED_BACKEND,
+    GEMM_PERF_EVENTS,
+};
+
+/**
+ * Counter values of a thread at one moment.
+ */
+typedef struct gemm_perf_sample {
+    uint64_t time_ns;
+    uint64_t enabled; /* Times the perf_event group was enabled and counting, multiplexed counts are scaled by them */
+    uint64_t running;
+    uint64_t values[GEMM_PERF_EVENTS];
+    unsigned valid; /* Bit mask of the events read, bit i for values[i] */
+    int group; /* The values were read from the perf_event group, not from rdcycle */
+} gemm_perf_sample_t;
+
+/**
+ * Entry point call being counted.
+ */
+typedef struct gemm_perf_scope {
+    const char *name;
+    size_t n;
+    size_t m;
+    size_t k;
+    uint64_t flops; /* Work of the call, it covers all products of batched and grouped calls */
+    struct gemm_perf_scope *outer; /* Call of the same thread this one is nested in, NULL for the outermost */
+    gemm_perf_sample_t start;
+    uint64_t workers[GEMM_PERF_EVENTS]; /* Events of the pool workers while they ran the tasks of the call */
+    unsigned workers_missing; /* Events a worker could not read, they are not counted for the call */
+} gemm_perf_scope_t;
+
+/**
+ * Tasks of a counted call run by a pool worker.
+ */
+typedef struct gemm_perf_worker {
+    gemm_perf_scope_t *scope; /* NULL if the call is not counted */
+    gemm_perf_sample_t start;
+} gemm_perf_worker_t;
+
+extern void gemm_perf_begin(gemm_perf_scope_t *scope, const char *name, const size_t n, const size_t m, const size_t k,
+                            const uint64_t flops);
+extern void gemm_perf_end(gemm_perf_scope_t *scope);
+
+/**
+ * Innermost call of the calling thread being counted, NULL if there is none.
+ */
+extern gemm_perf_scope_t *gemm_perf_current(void);
+extern void gemm_perf_worker_begin(gemm_perf_worker_t *worker, gemm_perf_scope_t *scope);
+extern void gemm_perf_worker_end(const gemm_perf_worker_t *worker);
+
+/*
+ * Counts the events of the calling thread between GEMM_PERF_BEGIN and GEMM_PERF_END of an entry point,
+ * adds the events of the pool workers running its tasks and adds the sum to the statistics of the entry point
+ * and shape, see gemm_perf_dump.
+ */
+#define GEMM_PERF_BEGIN(n, m, k, flops) \
+    gemm_perf_scope_t gemm_perf_scope_; \
+    gemm_perf_begin(&gemm_perf_scope_, __func__, (n), (m), (k), (flops))
+#define GEMM_PERF_END() gemm_perf_end(&gemm_perf_scope_)
+
+/*
+ * Hooks of the thread pool: the loop carries the call of the thread which published it, GEMM_PERF_POOL_SCOPE(),
+ * and every worker counts its events between GEMM_PERF_WORKER_BEGIN and GEMM_PERF_WORKER_END into that call.
+ */
+#define GEMM_PERF_POOL_SCOPE() gemm_perf_current()
+#define GEMM_PERF_WORKER_BEGIN(scope) \
+    gemm_perf_worker_t gemm_perf_worker_; \
+    gemm_perf_worker_begin(&gemm_perf_worker_, (scope))
+#define GEMM_PERF_WORKER_END() gemm_perf_worker_end(&gemm_perf_worker_)
+#else
+#define GEMM_PERF_BEGIN(n, m, k, flops) do {} while (0)
+#define GEMM_PERF_END() do {} while (0)
+#define GEMM_PERF_POOL_SCOPE() NULL
+#define GEMM_PERF_WORKER_BEGIN(scope) do {} while (0)
+#define GEMM_PERF_WORKER_END() do {} while (0)
+#endif
+
+#endif // GEMM_PERF_H
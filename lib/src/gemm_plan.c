@@ -0,0 +1,463 @@
+#include "gemm_kernel.h"
+#include "gemm_thread.h"
+#include "gemm_trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tasks per thread of GEMM_STRATEGY_GEMV, the rows (or columns) of C are split into that many runs per thread.
+ */
+#ifndef GEMM_GEMV_TASKS_PER_THREAD
+#define GEMM_GEMV_TASKS_PER_THREAD 4
+#endif
+
+/*
+ * Rows of C narrower than that are accumulated as dot products in GEMM_STRATEGY_UNPACKED and GEMM_STRATEGY_GEMV,
+ * wider ones as scaled rows of B.
+ */
+#ifndef GEMM_UNPACKED_DOT_COLS
+#define GEMM_UNPACKED_DOT_COLS 4
+#endif
+
+/*
+ * Snapshot of the dispatch table. A published snapshot is never changed or freed.
+ */
+typedef struct rule_table {
+    struct rule_table *allocated; /* Previously allocated snapshot */
+    size_t count;
+    gemm_rule_t rules[GEMM_MAX_RULES];
+} rule_table_t;
+
+/*
+ * Built-in dispatch table. Tiny products cost less than packing their operands and waking the pool,
+ * products with one or two rows or columns of C read every element of the other operand once,
+ * so packing copies as much data as the product reads.
+ */
+static const rule_table_t default_table = {
+    .count = 3,
+    .rules = {
+        {.max_work = 16 * 16 * 16, .strategy = GEMM_STRATEGY_UNPACKED, .backend = GEMM_BACKEND_AUTO},
+        {.max_n = 2, .strategy = GEMM_STRATEGY_GEMV, .backend = GEMM_BACKEND_AUTO},
+        {.max_k = 2, .strategy = GEMM_STRATEGY_GEMV, .backend = GEMM_BACKEND_AUTO},
+    },
+};
+
+/*
+ * Rule of the products no rule of the table matches.
+ */
+static const gemm_rule_t fallback_rule = {
+    .strategy = GEMM_STRATEGY_BLOCKED,
+    .backend = GEMM_BACKEND_AUTO,
+};
+
+/*
+ * Dispatch table. gemm reads the current snapshot with one acquire load and no lock, so the table may be
+ * replaced while other threads multiply. Replaced snapshots are kept in the `allocated` list instead of
+ * being freed, as a reader may still scan them; the table is set rarely, so this costs a few KB.
+ */
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock; /* Serializes the writers */
+    _Atomic(const rule_table_t *) current; /* NULL until the first table is loaded */
+    rule_table_t *allocated; /* All snapshots allocated by the writers */
+} plan = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * Arguments of the GEMM_STRATEGY_GEMV tasks: rows (by_rows != 0) or columns of C are split into `chunks` runs.
+ */
+typedef struct gemv_gemm {
+    const gemm_kernel_t *kernel;
+    const float *A;
+    const float *B;
+    float *C;
+    size_t n;
+    size_t m;
+    size_t k;
+    size_t chunks;
+    int by_rows;
+} gemv_gemm_t;
+
+static int valid_rule(const gemm_rule_t *rule) {
+    return ((rule->strategy == GEMM_STRATEGY_UNPACKED) || (rule->strategy == GEMM_STRATEGY_GEMV)
+            || (rule->strategy == GEMM_STRATEGY_BLOCKED) || (rule->strategy == GEMM_STRATEGY_RECURSIVE))
+           && (rule->backend >= GEMM_BACKEND_AUTO) && (rule->backend <= GEMM_BACKEND_RVM);
+}
+
+/**
+ * Makes the table current, an allocated table is also added to the list of the snapshots.
+ */
+static void publish(const rule_table_t *table, rule_table_t *allocated) {
+    pthread_mutex_lock(&plan.lock);
+    if (allocated != NULL) {
+        allocated->allocated = plan.allocated;
+        plan.allocated = allocated;
+    }
+    atomic_store_explicit(&plan.current, table, memory_order_release);
+    pthread_mutex_unlock(&plan.lock);
+}
+
+/**
+ * Publishes a new snapshot with the rules.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+static int store_rules(const gemm_rule_t *rules, const size_t count) {
+    rule_table_t *table = malloc(sizeof(*table));
+    if (table == NULL) {
+        return -1;
+    }
+    memcpy(table->rules, rules, count * sizeof(rules[0]));
+    table->count = count;
+    publish(table, table);
+    return 0;
+}
+
+static int parse_size(const char *value, size_t *result) {
+    char *end;
+    errno = 0;
+    const unsigned long long parsed = strtoull(value, &end, 10);
+    if ((errno != 0) || (end == value) || (*end != '\0') || (value[0] == '-')) {
+        return -1;
+    }
+    *result = (size_t)parsed;
+    return 0;
+}
+
+/**
+ * Parses a line of a config file: a strategy followed by key=value fields of the rule, the fields not given are 0
+ * (backend is auto). Empty lines and lines starting with '#' hold no rule.
+ *
+ * @return 1 if the line holds a rule, 0 if it holds none, -1 if it is invalid.
+ */
+static int parse_rule(char *line, gemm_rule_t *rule) {
+    char *save;
+    char *token = strtok_r(line, " \t\r\n", &save);
+    if ((token == NULL) || (token[0] == '#')) {
+        return 0;
+    }
+
+    memset(rule, 0, sizeof(*rule));
+    rule->backend = GEMM_BACKEND_AUTO;
+    if (strcmp(token, "unpacked") == 0) {
+        rule->strategy = GEMM_STRATEGY_UNPACKED;
+    } else if (strcmp(token, "gemv") == 0) {
+        rule->strategy = GEMM_STRATEGY_GEMV;
+    } else if (strcmp(token, "blocked") == 0) {
+        rule->strategy = GEMM_STRATEGY_BLOCKED;
+    } else if (strcmp(token, "recursive") == 0) {
+        rule->strategy = GEMM_STRATEGY_RECURSIVE;
+    } else {
+        return -1;
+    }
+
+    const struct {
+        const char *key;
+        size_t *field;
+    } fields[] = {
+        {"max_n", &rule->max_n},
+        {"max_m", &rule->max_m},
+        {"max_k", &rule->max_k},
+        {"max_work", &rule->max_work},
+        {"mc", &rule->mc},
+        {"kc", &rule->kc},
+        {"nc", &rule->nc},
+        {"threads", &rule->threads},
+    };
+
+    while ((token = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        if (token[0] == '#') {
+            break;
+        }
+        char *value = strchr(token, '=');
+        if (value == NULL) {
+            return -1;
+        }
+        *value++ = '\0';
+
+        if (strcmp(token, "backend") == 0) {
+            if (strcmp(value, "auto") == 0) {
+                rule->backend = GEMM_BACKEND_AUTO;
+            } else if (gemm_backend_by_name(value, &rule->backend) != 0) {
+                return -1;
+            }
+            continue;
+        }
+
+        size_t i = 0;
+        while ((i < sizeof(fields) / sizeof(fields[0])) && (strcmp(token, fields[i].key) != 0)) {
+            i++;
+        }
+        if ((i == sizeof(fields) / sizeof(fields[0])) || (parse_size(value, fields[i].field) != 0)) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+static int read_rules(const char *path, gemm_rule_t *rules, size_t *count) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    int status = 0;
+    *count = 0;
+    while ((status == 0) && (fgets(line, sizeof(line), file) != NULL)) {
+        gemm_rule_t rule;
+        const int parsed = parse_rule(line, &rule);
+        if (parsed < 0) {
+            status = -1;
+        } else if (parsed > 0) {
+            if (*count == GEMM_MAX_RULES) {
+                status = -1;
+            } else {
+                rules[(*count)++] = rule;
+            }
+        }
+    }
+    if (ferror(file)) {
+        status = -1;
+    }
+    fclose(file);
+    return status;
+}
+
+/**
+ * Initial table: the RMVGEMM_CONFIG file if it is set and valid, the built-in table otherwise.
+ */
+static void load_initial(void) {
+    gemm_rule_t rules[GEMM_MAX_RULES];
+    size_t count;
+    const char *path = getenv("RMVGEMM_CONFIG");
+    if ((path == NULL) || (read_rules(path, rules, &count) != 0) || (store_rules(rules, count) != 0)) {
+        publish(&default_table, NULL);
+    }
+}
+
+static int rule_matches(const gemm_rule_t *rule, const size_t n, const size_t m, const size_t k) {
+    return ((rule->max_n == 0) || (n <= rule->max_n))
+           && ((rule->max_m == 0) || (m <= rule->max_m))
+           && ((rule->max_k == 0) || (k <= rule->max_k))
+           && ((rule->max_work == 0) || (n * m * k <= rule->max_work));
+}
+
+extern int gemm_set_rules(const gemm_rule_t *rules, const size_t count)
+{
+    pthread_once(&plan.once, load_initial);
+    if (rules == NULL) {
+        load_initial();
+        return 0;
+    }
+    if (count > GEMM_MAX_RULES) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!valid_rule(&rules[i])) {
+            return -1;
+        }
+    }
+    return store_rules(rules, count);
+}
+
+extern int gemm_load_rules(const char *path)
+{
+    gemm_rule_t rules[GEMM_MAX_RULES];
+    size_t count;
+    pthread_once(&plan.once, load_initial);
+    if (read_rules(path, rules, &count) != 0) {
+        return -1;
+    }
+    return store_rules(rules, count);
+}
+
+extern gemm_rule_t gemm_get_rule(const size_t n, const size_t m, const size_t k)
+{
+    const rule_table_t *table = atomic_load_explicit(&plan.current, memory_order_acquire);
+    if (table == NULL) {
+        pthread_once(&plan.once, load_initial);
+        table = atomic_load_explicit(&plan.current, memory_order_acquire);
+    }
+    for (size_t i = 0; i < table->count; i++) {
+        if (rule_matches(&table->rules[i], n, m, k)) {
+            return table->rules[i];
+        }
+    }
+    return fallback_rule;
+}
+
+/**
+ * Backend of the rule, the selected one if the rule has none or the hart does not support it.
+ */
+static gemm_backend_t rule_backend(const gemm_rule_t *rule) {
+    const int supported = (rule->backend != GEMM_BACKEND_AUTO) && (gemm_backend_kernel(rule->backend) != NULL);
+    return supported ? rule->backend : gemm_get_backend();
+}
+
+/**
+ * C += A * B for a rows x cols block of C without packing.
+ * Narrow rows of C are accumulated as dot products, wide ones as rows of B scaled by A[i][p],
+ * which walk B and C with unit stride: by the row kernel of the kernel if it has one, by a scalar loop otherwise.
+ */
+static void unpacked(const gemm_kernel_t *kernel, const float *A, const size_t lda, const float *B, const size_t ldb,
+                     float *C, const size_t ldc, const size_t rows, const size_t m, const size_t cols)
+{
+    if (cols < GEMM_UNPACKED_DOT_COLS) {
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                float sum = 0.0f;
+                for (size_t p = 0; p < m; p++) {
+                    sum += A[(i * lda) + p] * B[(p * ldb) + j];
+                }
+                C[(i * ldc) + j] += sum;
+            }
+        }
+        return;
+    }
+
+    if (kernel->row_kernel != NULL) {
+        for (size_t i = 0; i < rows; i++) {
+            kernel->row_kernel(m, cols, &A[i * lda], B, ldb, &C[i * ldc]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t p = 0; p < m; p++) {
+            const float a = A[(i * lda) + p];
+            for (size_t j = 0; j < cols; j++) {
+                C[(i * ldc) + j] += a * B[(p * ldb) + j];
+            }
+        }
+    }
+}
+
+static void gemv_task(void *arg, const size_t task) {
+    const gemv_gemm_t *g = arg;
+    const size_t length = g->by_rows ? g->n : g->k;
+    const size_t begin = (task * length) / g->chunks;
+    const size_t end = ((task + 1) * length) / g->chunks;
+
+    if (g->by_rows) {
+        unpacked(g->kernel, &g->A[begin * g->m], g->m, g->B, g->k, &g->C[begin * g->k], g->k, end - begin, g->m, g->k);
+    } else {
+        unpacked(g->kernel, g->A, g->m, &g->B[begin], g->k, &g->C[begin], g->k, g->n, g->m, end - begin);
+    }
+}
+
+/**
+ * GEMM_STRATEGY_GEMV: splits the longer of the rows and the columns of C between the threads.
+ */
+static void gemv(const gemm_rule_t *rule, const gemm_kernel_t *kernel, const float *A, const float *B, float *C,
+                 const size_t n, const size_t m, const size_t k)
+{
+    const size_t threads = ((n * m * k) < gemm_get_parallel_threshold()) ? 1
+                         : (rule->threads != 0) ? MIN(rule->threads, gemm_get_num_threads()) : gemm_get_num_threads();
+    const int by_rows = n >= k;
+    const size_t length = by_rows ? n : k;
+
+    if ((threads <= 1) || (length <= 1)) {
+        unpacked(kernel, A, m, B, k, C, k, n, m, k);
+        return;
+    }
+
+    gemv_gemm_t g = {
+        .kernel = kernel,
+        .A = A,
+        .B = B,
+        .C = C,
+        .n = n,
+        .m = m,
+        .k = k,
+        .chunks = MIN(length, threads * GEMM_GEMV_TASKS_PER_THREAD),
+        .by_rows = by_rows,
+    };
+    gemm_parallel_for_threads(g.chunks, threads, gemv_task, &g);
+}
+
+/**
+ * Operands of C += A * B for the row-major matrices of gemm.
+ */
+static gemm_args_t product_args(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    const gemm_args_t args = {
+        .n = n,
+        .m = m,
+        .k = k,
+        .alpha = 1.0f,
+        .A = A,
+        .rs_a = m,
+        .cs_a = 1,
+        .B = B,
+        .rs_b = k,
+        .cs_b = 1,
+        .B_packed = NULL,
+        .beta = 1.0f,
+        .C = C,
+        .ldc = k,
+        .row_bias = NULL,
+        .col_bias = NULL,
+        .activation = GEMM_ACTIVATION_NONE,
+    };
+    return args;
+}
+
+/**
+ * GEMM_STRATEGY_BLOCKED: the driver with the kernel, panel sizes and threads of the rule.
+ * Panel sizes are rounded up to the register blocks of the kernel.
+ */
+static void blocked(const gemm_rule_t *rule, const gemm_kernel_t *kernel, const float *A, const float *B, float *C,
+                    const size_t n, const size_t m, const size_t k)
+{
+    const gemm_blocking_t blocking = {
+        .mc = (rule->mc != 0) ? ROUND_UP(rule->mc, kernel->mr) : gemm_default_blocking.mc,
+        .kc = (rule->kc != 0) ? ROUND_UP(rule->kc, kernel->kr) : gemm_default_blocking.kc,
+        .nc = (rule->nc != 0) ? ROUND_UP(rule->nc, kernel->nr) : gemm_default_blocking.nc,
+    };
+    const gemm_args_t args = product_args(A, B, C, n, m, k);
+    gemm_driver_threads(kernel, &blocking, &args, (rule->threads != 0) ? rule->threads : gemm_get_num_threads());
+}
+
+/**
+ * GEMM_STRATEGY_RECURSIVE: the recursive driver with the kernel and threads of the rule.
+ */
+static void recursive(const gemm_rule_t *rule, const gemm_kernel_t *kernel, const float *A, const float *B, float *C,
+                      const size_t n, const size_t m, const size_t k)
+{
+    const gemm_args_t args = product_args(A, B, C, n, m, k);
+    gemm_driver_recursive(kernel, &args, (rule->threads != 0) ? rule->threads : gemm_get_num_threads());
+}
+
+extern void gemm(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
+{
+    // The trace records the backend which runs the product: the unpacked loops are scalar without a row kernel
+    const gemm_rule_t rule = gemm_get_rule(n, m, k);
+    const gemm_backend_t backend = rule_backend(&rule);
+    const gemm_kernel_t *kernel = gemm_backend_kernel(backend);
+    const int scalar = ((rule.strategy == GEMM_STRATEGY_UNPACKED) || (rule.strategy == GEMM_STRATEGY_GEMV))
+                       && (kernel->row_kernel == NULL);
+
+    GEMM_TRACE_BEGIN(scalar ? GEMM_BACKEND_REF : backend, n, m, k);
+    switch (rule.strategy) {
+    case GEMM_STRATEGY_UNPACKED:
+        unpacked(kernel, A, m, B, k, C, k, n, m, k);
+        break;
+    case GEMM_STRATEGY_GEMV:
+        gemv(&rule, kernel, A, B, C, n, m, k);
+        break;
+    case GEMM_STRATEGY_RECURSIVE:
+        recursive(&rule, kernel, A, B, C, n, m, k);
+        break;
+    default:
+        blocked(&rule, kernel, A, B, C, n, m, k);
+        break;
+    }
+    GEMM_TRACE_END();
+}
@@ -0,0 +1,63 @@
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+// Packed blocks start at the first GEMM_PACK_ALIGN boundary after the handle.
+#define PACKED_B_HEADER ROUND_UP(sizeof(gemm_packed_b), GEMM_PACK_ALIGN)
+
+/**
+ * Size in bytes of a buffer for gemm_pack_b_to.
+ * Reserves GEMM_PACK_ALIGN extra bytes, so the buffer itself may have any alignment.
+ * The backend may change before B is packed, so the buffer fits the panels of every kernel.
+ */
+extern size_t gemm_packed_b_size(const size_t m, const size_t k)
+{
+    const gemm_kernel_t *const kernels[] = {&gemm_kernel_ref, &gemm_kernel_rvv, &gemm_kernel_rvm};
+    size_t data = 0;
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        data = MAX(data, gemm_pack_b_blocks_size(kernels[i], &gemm_default_blocking, m, k) * sizeof(float));
+    }
+    return PACKED_B_HEADER + data + GEMM_PACK_ALIGN;
+}
+
+extern gemm_packed_b *gemm_pack_b_to(const float *B, const size_t m, const size_t k, void *buffer)
+{
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    const uintptr_t base = ROUND_UP((uintptr_t)buffer, (uintptr_t)GEMM_PACK_ALIGN);
+    gemm_packed_b *packed = (gemm_packed_b *)base;
+    packed->kernel = gemm_dispatch_kernel();
+    packed->blocking = gemm_default_blocking;
+    packed->m = m;
+    packed->k = k;
+    packed->data = (float *)(base + PACKED_B_HEADER);
+    packed->allocation = NULL;
+
+    gemm_pack_b_blocks(packed->kernel, &packed->blocking, B, k, 1, m, k, packed->data);
+    return packed;
+}
+
+extern gemm_packed_b *gemm_pack_b(const float *B, const size_t m, const size_t k)
+{
+    void *buffer = malloc(gemm_packed_b_size(m, k));
+    gemm_packed_b *packed = gemm_pack_b_to(B, m, k, buffer);
+    if (packed != NULL) {
+        packed->allocation = buffer;
+    }
+    return packed;
+}
+
+extern void gemm_packed_b_free(gemm_packed_b *packed)
+{
+    if (packed != NULL) {
+        free(packed->allocation);
+    }
+}
+
+extern void gemm_rvm_prepacked(const float *A, const gemm_packed_b *packedB, float *C, const size_t n)
+{
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_AUTO, n, packedB->m, packedB->k);
+    gemm_driver_prepacked(packedB, A, packedB->m, C, packedB->k, n);
+    GEMM_TRACE_END();
+}
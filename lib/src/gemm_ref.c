@@ -1,4 +1,5 @@
 #include "gemm.h"
+#include "gemm_trace.h"
 
 /**
  * Multiplies two matrices.
@@ -12,6 +13,7 @@
  */
 extern void gemm_ref(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k)
 {
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_REF, n, m, k);
     for (size_t i = 0; i < n; i++) { /* Loop over the rows of C */
         for (size_t j = 0; j < k; j++) { /* Loop over the columns of C */
             for (size_t p = 0; p < m; p++) {  /* Update C( i,j ) with the inner
@@ -21,4 +23,5 @@ extern void gemm_ref(const float *A, const float *B, float *C, const size_t n, c
             }
         }
     }
+    GEMM_TRACE_END();
 }
@@ -0,0 +1,95 @@
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+/**
+ * Checks the parameters of sgemm as the reference BLAS does, with the leading dimensions at least 1.
+ */
+extern int gemm_sgemm_check(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                            const size_t M, const size_t N, const size_t K,
+                            const size_t lda, const size_t ldb, const size_t ldc)
+{
+    if ((layout != GEMM_ROW_MAJOR) && (layout != GEMM_COL_MAJOR)) {
+        return 1;
+    }
+    if ((transA != GEMM_NO_TRANS) && (transA != GEMM_TRANS)) {
+        return 2;
+    }
+    if ((transB != GEMM_NO_TRANS) && (transB != GEMM_TRANS)) {
+        return 3;
+    }
+
+    // Elements in a stored row (row-major) or column (column-major) of A, B and C
+    const int row_major = (layout == GEMM_ROW_MAJOR);
+    const size_t a = ((transA == GEMM_NO_TRANS) == row_major) ? K : M;
+    const size_t b = ((transB == GEMM_NO_TRANS) == row_major) ? N : K;
+    const size_t c = row_major ? N : M;
+    if (lda < MAX(a, 1)) {
+        return 9;
+    }
+    if (ldb < MAX(b, 1)) {
+        return 11;
+    }
+    if (ldc < MAX(c, 1)) {
+        return 14;
+    }
+    return 0;
+}
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C with the given kernel, the parameters are checked by the caller.
+ * A column-major product is computed as the row-major product C^T = op(B)^T * op(A)^T,
+ * transposed operands are packed with swapped strides.
+ */
+extern void gemm_sgemm(const gemm_kernel_t *kernel,
+                       const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                       const size_t M, const size_t N, const size_t K, const float alpha,
+                       const float *A, const size_t lda, const float *B, const size_t ldb,
+                       const float beta, float *C, const size_t ldc)
+{
+    if (layout == GEMM_COL_MAJOR) {
+        gemm_sgemm(kernel, GEMM_ROW_MAJOR, transB, transA, N, M, K, alpha, B, ldb, A, lda, beta, C, ldc);
+        return;
+    }
+
+    const gemm_args_t args = {
+        .n = M,
+        .m = K,
+        .k = N,
+        .alpha = alpha,
+        .A = A,
+        .rs_a = (transA == GEMM_NO_TRANS) ? lda : 1,
+        .cs_a = (transA == GEMM_NO_TRANS) ? 1 : lda,
+        .B = B,
+        .rs_b = (transB == GEMM_NO_TRANS) ? ldb : 1,
+        .cs_b = (transB == GEMM_NO_TRANS) ? 1 : ldb,
+        .B_packed = NULL,
+        .beta = beta,
+        .C = C,
+        .ldc = ldc,
+        .row_bias = NULL,
+        .col_bias = NULL,
+        .activation = GEMM_ACTIVATION_NONE,
+    };
+    gemm_driver_args(kernel, NULL, &args);
+}
+
+/**
+ * Computes C = alpha * op(A) * op(B) + beta * C, where op(X) is X or its transpose.
+ */
+extern int sgemm(const gemm_layout_t layout, const gemm_transpose_t transA, const gemm_transpose_t transB,
+                 const size_t M, const size_t N, const size_t K, const float alpha,
+                 const float *A, const size_t lda, const float *B, const size_t ldb,
+                 const float beta, float *C, const size_t ldc)
+{
+    const int info = gemm_sgemm_check(layout, transA, transB, M, N, K, lda, ldb, ldc);
+    if (info != 0) {
+        return info;
+    }
+
+    // The backend is read once, so the trace records the one which runs even if another thread changes it
+    const gemm_backend_t backend = gemm_get_backend();
+    GEMM_TRACE_BEGIN(backend, M, K, N);
+    gemm_sgemm(gemm_backend_kernel(backend), layout, transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    GEMM_TRACE_END();
+    return 0;
+}
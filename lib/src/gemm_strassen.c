@@ -0,0 +1,190 @@
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+#include <string.h>
+
+/*
+ * Smallest crossover: halves of a split dimension are multiples of 4, so the kernel gets whole 4x4 tiles.
+ */
+#define STRASSEN_MIN_CROSSOVER 8
+
+static size_t crossover_or_default(const size_t crossover) {
+    return (crossover == 0) ? GEMM_STRASSEN_CROSSOVER : MAX(crossover, STRASSEN_MIN_CROSSOVER);
+}
+
+/**
+ * Size of the quadrants of a split dimension, a multiple of 4. The remaining size % 8 elements are peeled off
+ * and multiplied by the kernel directly.
+ */
+static size_t half(const size_t size) {
+    return (size / 8) * 4;
+}
+
+static int is_leaf(const size_t n, const size_t m, const size_t k, const size_t crossover) {
+    return MIN(n, MIN(m, k)) <= crossover;
+}
+
+/**
+ * Floats of the temporaries of a product and all recursion levels below it.
+ */
+static size_t workspace_floats(const size_t n, const size_t m, const size_t k, const size_t crossover) {
+    if (is_leaf(n, m, k, crossover)) {
+        return 0;
+    }
+    const size_t hn = half(n);
+    const size_t hm = half(m);
+    const size_t hk = half(k);
+    return (hn * hm) + (hm * hk) + (hn * hk) + workspace_floats(hn, hm, hk, crossover);
+}
+
+/**
+ * Z = X + Y for rows x cols matrices, Z may be X or Y.
+ */
+static void add(const size_t rows, const size_t cols, const float *X, const size_t ldx, const float *Y, const size_t ldy,
+                float *Z, const size_t ldz)
+{
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            Z[(i * ldz) + j] = X[(i * ldx) + j] + Y[(i * ldy) + j];
+        }
+    }
+}
+
+/**
+ * Z = X - Y for rows x cols matrices, Z may be X or Y.
+ */
+static void sub(const size_t rows, const size_t cols, const float *X, const size_t ldx, const float *Y, const size_t ldy,
+                float *Z, const size_t ldz)
+{
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            Z[(i * ldz) + j] = X[(i * ldx) + j] - Y[(i * ldy) + j];
+        }
+    }
+}
+
+static void zero(const size_t rows, const size_t cols, float *Z, const size_t ldz) {
+    for (size_t i = 0; i < rows; i++) {
+        memset(&Z[i * ldz], 0, cols * sizeof(float));
+    }
+}
+
+/**
+ * Computes C += A * B with Winograd's variant of Strassen's algorithm (7 products and 15 additions per level
+ * instead of 8 products):
+ *   S1 = A21 + A22   S2 = S1 - A11   S3 = A11 - A21   S4 = A12 - S2
+ *   T1 = B12 - B11   T2 = B22 - T1   T3 = B22 - B12   T4 = T2 - B21
+ *   M1 = A11 * B11   M2 = A12 * B21  M3 = S4 * B22    M4 = A22 * T4   M5 = S1 * T1   M6 = S2 * T2   M7 = S3 * T3
+ *   C11 += M1 + M2   C12 += M1 + M6 + M5 + M3   C21 += M1 + M6 + M7 - M4   C22 += M1 + M6 + M7 + M5
+ * Products going to a single quadrant accumulate into C directly, the others go through one temporary
+ * P, so a level needs S (hn x hm), T (hm x hk) and P (hn x hk). Rows and columns beyond the quadrants
+ * are multiplied by the kernel of gemm_block4x4_rvm, as are the products at or below the crossover.
+ */
+static void strassen(const float *A, const size_t lda, const float *B, const size_t ldb, float *C, const size_t ldc,
+                     const size_t n, const size_t m, const size_t k, const size_t crossover, float *workspace)
+{
+    if (is_leaf(n, m, k, crossover)) {
+        gemm_driver(&gemm_kernel_rvm, NULL, A, lda, B, ldb, C, ldc, n, m, k);
+        return;
+    }
+
+    const size_t hn = half(n);
+    const size_t hm = half(m);
+    const size_t hk = half(k);
+
+    const float *A11 = A;
+    const float *A12 = &A[hm];
+    const float *A21 = &A[hn * lda];
+    const float *A22 = &A[(hn * lda) + hm];
+    const float *B11 = B;
+    const float *B12 = &B[hk];
+    const float *B21 = &B[hm * ldb];
+    const float *B22 = &B[(hm * ldb) + hk];
+    float *C11 = C;
+    float *C12 = &C[hk];
+    float *C21 = &C[hn * ldc];
+    float *C22 = &C[(hn * ldc) + hk];
+
+    float *S = workspace;
+    float *T = &S[hn * hm];
+    float *P = &T[hm * hk];
+    float *next = &P[hn * hk];
+
+    // P = M1, C11 += M1 + M2
+    zero(hn, hk, P, hk);
+    strassen(A11, lda, B11, ldb, P, hk, hn, hm, hk, crossover, next);
+    add(hn, hk, C11, ldc, P, hk, C11, ldc);
+    strassen(A12, lda, B21, ldb, C11, ldc, hn, hm, hk, crossover, next);
+
+    // P = M1 + M6 goes to C12, C21 and C22
+    add(hn, hm, A21, lda, A22, lda, S, hm);
+    sub(hn, hm, S, hm, A11, lda, S, hm);
+    sub(hm, hk, B22, ldb, B12, ldb, T, hk);
+    add(hm, hk, T, hk, B11, ldb, T, hk);
+    strassen(S, hm, T, hk, P, hk, hn, hm, hk, crossover, next);
+    add(hn, hk, C12, ldc, P, hk, C12, ldc);
+    add(hn, hk, C21, ldc, P, hk, C21, ldc);
+    add(hn, hk, C22, ldc, P, hk, C22, ldc);
+
+    // C12 += M3 with S4 = A12 - S2, C21 -= M4 as A22 * (B21 - T2)
+    sub(hn, hm, A12, lda, S, hm, S, hm);
+    strassen(S, hm, B22, ldb, C12, ldc, hn, hm, hk, crossover, next);
+    sub(hm, hk, B21, ldb, T, hk, T, hk);
+    strassen(A22, lda, T, hk, C21, ldc, hn, hm, hk, crossover, next);
+
+    // P = M5 goes to C12 and C22
+    add(hn, hm, A21, lda, A22, lda, S, hm);
+    sub(hm, hk, B12, ldb, B11, ldb, T, hk);
+    zero(hn, hk, P, hk);
+    strassen(S, hm, T, hk, P, hk, hn, hm, hk, crossover, next);
+    add(hn, hk, C12, ldc, P, hk, C12, ldc);
+    add(hn, hk, C22, ldc, P, hk, C22, ldc);
+
+    // P = M7 goes to C21 and C22
+    sub(hn, hm, A11, lda, A21, lda, S, hm);
+    sub(hm, hk, B22, ldb, B12, ldb, T, hk);
+    zero(hn, hk, P, hk);
+    strassen(S, hm, T, hk, P, hk, hn, hm, hk, crossover, next);
+    add(hn, hk, C21, ldc, P, hk, C21, ldc);
+    add(hn, hk, C22, ldc, P, hk, C22, ldc);
+
+    // Peeled rows and columns: the rest of the inner dimension, then the columns and rows of C beyond the quadrants
+    const size_t n2 = 2 * hn;
+    const size_t m2 = 2 * hm;
+    const size_t k2 = 2 * hk;
+    if (m > m2) {
+        gemm_driver(&gemm_kernel_rvm, NULL, &A[m2], lda, &B[m2 * ldb], ldb, C, ldc, n2, m - m2, k2);
+    }
+    if (k > k2) {
+        gemm_driver(&gemm_kernel_rvm, NULL, A, lda, &B[k2], ldb, &C[k2], ldc, n2, m, k - k2);
+    }
+    if (n > n2) {
+        gemm_driver(&gemm_kernel_rvm, NULL, &A[n2 * lda], lda, B, ldb, &C[n2 * ldc], ldc, n - n2, m, k);
+    }
+}
+
+extern size_t gemm_strassen_workspace_size(const size_t n, const size_t m, const size_t k, const size_t crossover)
+{
+    return workspace_floats(n, m, k, crossover_or_default(crossover)) * sizeof(float);
+}
+
+extern int gemm_strassen(const float *A, const float *B, float *C, const size_t n, const size_t m, const size_t k,
+                         const size_t crossover, void *workspace)
+{
+    const size_t leaf = crossover_or_default(crossover);
+    void *allocation = NULL;
+    if ((workspace == NULL) && !is_leaf(n, m, k, leaf)) {
+        allocation = malloc(gemm_strassen_workspace_size(n, m, k, leaf));
+        if (allocation == NULL) {
+            return -1;
+        }
+        workspace = allocation;
+    }
+
+    GEMM_TRACE_BEGIN(GEMM_BACKEND_RVM, n, m, k);
+    strassen(A, m, B, k, C, k, n, m, k, leaf, (float *)workspace);
+    GEMM_TRACE_END();
+
+    free(allocation);
+    return 0;
+}
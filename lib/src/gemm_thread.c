@@ -0,0 +1,366 @@
+#include "gemm_thread.h"
+#include "gemm_kernel.h"
+#include "gemm_perf.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Iterations a thread polls a futex word before going to sleep.
+ * Back-to-back calls find the workers still spinning and do not pay for a wake-up.
+ */
+#ifndef GEMM_SPIN_COUNT
+#define GEMM_SPIN_COUNT 4096
+#endif
+
+/*
+ * Default serial threshold: problems with fewer than n * m * k multiply-adds run on the calling thread.
+ * Can be set from the build with -DGEMM_PARALLEL_THRESHOLD=... or at run time with gemm_set_parallel_threshold.
+ */
+#ifndef GEMM_PARALLEL_THRESHOLD
+#define GEMM_PARALLEL_THRESHOLD (128 * 128 * 128)
+#endif
+
+// Value returned by a deque without tasks.
+#define NO_TASK ((ptrdiff_t)-1)
+// Value returned by a steal which lost a race, the deque may still have tasks.
+#define ABORT_TASK ((ptrdiff_t)-2)
+
+/**
+ * Chase-Lev work-stealing deque over a range of task indices.
+ * The owner pops tasks from the bottom, other threads steal them from the top.
+ * All tasks are added before the loop is published, so the deque never grows and
+ * task i of the deque is simply first + i.
+ */
+typedef struct task_deque {
+    _Alignas(64) _Atomic ptrdiff_t top;
+    _Atomic ptrdiff_t bottom;
+    size_t first;
+} task_deque_t;
+
+/*
+ * Persistent pool: workers are started on the first parallel call and then wait for the next epoch,
+ * first polling and then sleeping on a futex. A loop is published with the job fields and a single
+ * increment of the epoch. Every thread taking part gets a contiguous range of tasks in its deque,
+ * runs them and then steals from the other deques. The calling thread is worker 0 and waits until
+ * every started worker has acknowledged the epoch in the `finished` counter, so the job fields are
+ * not rewritten while a worker reads them.
+ */
+static struct {
+    pthread_mutex_t dispatch; /* Held by the thread which owns the pool for the current loop */
+    size_t started; /* Workers started, without the calling thread */
+    _Atomic size_t nthreads; /* Configured number of threads, 0 until initialized */
+    _Atomic size_t threshold;
+
+    _Atomic uint32_t epoch; /* Incremented for every loop */
+    _Atomic uint32_t epoch_sleepers; /* Workers sleeping on epoch */
+    _Atomic uint32_t finished; /* Started workers done with the current loop */
+    _Atomic uint32_t finished_sleepers; /* 1 if the calling thread sleeps on finished */
+
+    /* Current loop, published by the epoch increment */
+    size_t active;
+    gemm_task_t task;
+    void *arg;
+    double start; /* Time the loop was published, late wake-ups of the workers count as busy time */
+    struct gemm_perf_scope *perf; /* Counted call of the thread which published the loop, see gemm_perf.h */
+    task_deque_t deques[GEMM_MAX_THREADS];
+    gemm_parallel_stats_t stats;
+} pool = {
+    .dispatch = PTHREAD_MUTEX_INITIALIZER,
+    .threshold = GEMM_PARALLEL_THRESHOLD,
+};
+
+typedef struct worker_arg {
+    size_t id;
+    uint32_t epoch; /* Epoch before the first loop of the worker */
+} worker_arg_t;
+
+static worker_arg_t worker_args[GEMM_MAX_THREADS];
+
+static __thread int in_parallel = 0;
+
+static void futex_wait(_Atomic uint32_t *word, const uint32_t value) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)value;
+    sched_yield();
+#endif
+}
+
+static void futex_wake(_Atomic uint32_t *word) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * Waits until *word differs from value and returns the new value.
+ * The sleepers counter lets the writer skip the wake-up system call when nobody sleeps.
+ */
+static uint32_t wait_change(_Atomic uint32_t *word, const uint32_t value, _Atomic uint32_t *sleepers) {
+    for (size_t spin = 0; spin < GEMM_SPIN_COUNT; spin++) {
+        const uint32_t current = atomic_load_explicit(word, memory_order_acquire);
+        if (current != value) {
+            return current;
+        }
+    }
+    for (;;) {
+        // Sequentially consistent with the writer: either it sees the sleeper or we see the new value.
+        atomic_fetch_add(sleepers, 1);
+        if (atomic_load(word) == value) {
+            futex_wait(word, value);
+        }
+        atomic_fetch_sub(sleepers, 1);
+        const uint32_t current = atomic_load_explicit(word, memory_order_acquire);
+        if (current != value) {
+            return current;
+        }
+    }
+}
+
+/**
+ * Wakes the threads sleeping on word after it was changed.
+ */
+static void notify(_Atomic uint32_t *word, _Atomic uint32_t *sleepers) {
+    if (atomic_load(sleepers) != 0) {
+        futex_wake(word);
+    }
+}
+
+/**
+ * Takes a task from the bottom of the own deque.
+ */
+static ptrdiff_t deque_pop(task_deque_t *deque) {
+    const ptrdiff_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    ptrdiff_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return NO_TASK;
+    }
+    if (t == b) {
+        // The last task: race with the thieves for it.
+        const int won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                                memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return won ? b : NO_TASK;
+    }
+    return b;
+}
+
+/**
+ * Takes a task from the top of another thread's deque.
+ */
+static ptrdiff_t deque_steal(task_deque_t *deque) {
+    ptrdiff_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const ptrdiff_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return NO_TASK;
+    }
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return ABORT_TASK;
+    }
+    return t;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+/**
+ * Runs the tasks of one thread: first its own deque, then whatever is left in the others.
+ */
+static void run_tasks(const size_t id, const size_t active, gemm_task_t task, void *arg, const double start) {
+    size_t executed = 0;
+    size_t stolen = 0;
+
+    task_deque_t *own = &pool.deques[id];
+    for (ptrdiff_t t = deque_pop(own); t != NO_TASK; t = deque_pop(own)) {
+        task(arg, own->first + (size_t)t);
+        executed += 1;
+    }
+
+    for (size_t i = 1; i < active; i++) {
+        task_deque_t *victim = &pool.deques[(id + i) % active];
+        for (;;) {
+            const ptrdiff_t t = deque_steal(victim);
+            if (t == NO_TASK) {
+                break;
+            }
+            if (t != ABORT_TASK) {
+                task(arg, victim->first + (size_t)t);
+                executed += 1;
+                stolen += 1;
+            }
+        }
+    }
+
+    pool.stats.executed[id] = executed;
+    pool.stats.stolen[id] = stolen;
+    pool.stats.busy[id] = now_seconds() - start;
+}
+
+static void *worker_main(void *arg) {
+    const worker_arg_t *worker = (const worker_arg_t *)arg;
+    const size_t id = worker->id;
+    uint32_t seen = worker->epoch;
+
+    in_parallel = 1;
+    for (;;) {
+        seen = wait_change(&pool.epoch, seen, &pool.epoch_sleepers);
+        if (id < pool.active) {
+            GEMM_PERF_WORKER_BEGIN(pool.perf);
+            run_tasks(id, pool.active, pool.task, pool.arg, pool.start);
+            GEMM_PERF_WORKER_END();
+        }
+
+        atomic_fetch_add(&pool.finished, 1);
+        notify(&pool.finished, &pool.finished_sleepers);
+    }
+    return NULL;
+}
+
+/**
+ * Default number of threads: RMVGEMM_NUM_THREADS or the number of online harts.
+ */
+static size_t default_thread_count(void) {
+    const char *env = getenv("RMVGEMM_NUM_THREADS");
+    if (env != NULL) {
+        const long count = strtol(env, NULL, 10);
+        if (count > 0) {
+            return (size_t)count;
+        }
+    }
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return (online > 0) ? (size_t)online : 1;
+}
+
+/**
+ * Sets the number of threads used by the GEMM functions.
+ *
+ * @param count Number of threads, 0 restores the default (RMVGEMM_NUM_THREADS or the number of harts).
+ */
+extern void gemm_set_num_threads(const size_t count)
+{
+    const size_t nthreads = (count != 0) ? count : default_thread_count();
+    atomic_store(&pool.nthreads, MIN(nthreads, GEMM_MAX_THREADS));
+}
+
+/**
+ * Number of threads used by the GEMM functions.
+ */
+extern size_t gemm_get_num_threads(void)
+{
+    size_t nthreads = atomic_load_explicit(&pool.nthreads, memory_order_relaxed);
+    if (nthreads == 0) {
+        size_t expected = 0;
+        nthreads = MIN(default_thread_count(), GEMM_MAX_THREADS);
+        if (!atomic_compare_exchange_strong(&pool.nthreads, &expected, nthreads)) {
+            nthreads = expected;
+        }
+    }
+    return nthreads;
+}
+
+/**
+ * Sets the smallest problem (n * m * k multiply-adds) which is split between threads.
+ *
+ * @param threshold Number of multiply-adds, 0 makes every problem parallel.
+ */
+extern void gemm_set_parallel_threshold(const size_t threshold)
+{
+    atomic_store(&pool.threshold, threshold);
+}
+
+/**
+ * Smallest problem (n * m * k multiply-adds) which is split between threads.
+ */
+extern size_t gemm_get_parallel_threshold(void)
+{
+    return atomic_load_explicit(&pool.threshold, memory_order_relaxed);
+}
+
+extern void gemm_parallel_for(const size_t ntasks, gemm_task_t task, void *arg)
+{
+    gemm_parallel_for_threads(ntasks, gemm_get_num_threads(), task, arg);
+}
+
+extern void gemm_parallel_for_threads(const size_t ntasks, const size_t threads, gemm_task_t task, void *arg)
+{
+    size_t active = MIN(MIN(threads, gemm_get_num_threads()), ntasks);
+
+    if ((active <= 1) || in_parallel || (pthread_mutex_trylock(&pool.dispatch) != 0)) {
+        for (size_t t = 0; t < ntasks; t++) {
+            task(arg, t);
+        }
+        return;
+    }
+
+    const uint32_t epoch = atomic_load_explicit(&pool.epoch, memory_order_relaxed);
+    while (pool.started + 1 < active) {
+        const size_t id = pool.started + 1;
+        worker_args[id].id = id;
+        worker_args[id].epoch = epoch;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, &worker_args[id]) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+        pool.started = id;
+    }
+    active = MIN(active, pool.started + 1);
+
+    for (size_t id = 0; id < active; id++) {
+        const size_t first = (ntasks * id) / active;
+        const size_t last = (ntasks * (id + 1)) / active;
+        pool.deques[id].first = first;
+        atomic_store_explicit(&pool.deques[id].top, 0, memory_order_relaxed);
+        atomic_store_explicit(&pool.deques[id].bottom, (ptrdiff_t)(last - first), memory_order_relaxed);
+    }
+    pool.active = active;
+    pool.task = task;
+    pool.arg = arg;
+    pool.start = now_seconds();
+    pool.perf = GEMM_PERF_POOL_SCOPE();
+    atomic_store_explicit(&pool.finished, 0, memory_order_relaxed);
+    atomic_fetch_add(&pool.epoch, 1);
+    notify(&pool.epoch, &pool.epoch_sleepers);
+
+    in_parallel = 1;
+    run_tasks(0, active, task, arg, pool.start);
+    in_parallel = 0;
+
+    for (uint32_t finished = atomic_load_explicit(&pool.finished, memory_order_acquire); finished < pool.started;) {
+        finished = wait_change(&pool.finished, finished, &pool.finished_sleepers);
+    }
+    pool.stats.threads = active;
+    pool.stats.tasks = ntasks;
+
+    pthread_mutex_unlock(&pool.dispatch);
+}
+
+extern void gemm_parallel_get_stats(gemm_parallel_stats_t *stats)
+{
+    pthread_mutex_lock(&pool.dispatch);
+    *stats = pool.stats;
+    pthread_mutex_unlock(&pool.dispatch);
+}
@@ -0,0 +1,51 @@
+#ifndef GEMM_THREAD_H
+#define GEMM_THREAD_H
+
+#include <stddef.h>
+
+// Upper bound of threads in the pool, including the calling thread.
+#define GEMM_MAX_THREADS 64
+
+/**
+ * Task of a parallel loop.
+ *
+ * @param arg Argument passed to gemm_parallel_for.
+ * @param task Index of the task.
+ */
+typedef void (*gemm_task_t)(void *arg, const size_t task);
+
+/**
+ * Runs tasks 0 .. ntasks - 1 on gemm_get_num_threads() threads and waits for all of them.
+ * Every thread starts with a contiguous range of tasks and steals from the others when done,
+ * so tasks of different cost are balanced. The calling thread takes part in the work. Nested calls and calls made while the pool
+ * is busy with another GEMM run the tasks on the calling thread.
+ *
+ * @param ntasks Number of tasks.
+ * @param task Function called for every task.
+ * @param arg Argument passed to the function.
+ */
+extern void gemm_parallel_for(const size_t ntasks, gemm_task_t task, void *arg);
+
+/**
+ * gemm_parallel_for on at most `threads` threads (and at most gemm_get_num_threads()).
+ */
+extern void gemm_parallel_for_threads(const size_t ntasks, const size_t threads, gemm_task_t task, void *arg);
+
+/**
+ * Statistics of the last loop run on the thread pool.
+ */
+typedef struct gemm_parallel_stats {
+    size_t threads; /* Threads which took part */
+    size_t tasks;
+    size_t executed[GEMM_MAX_THREADS]; /* Tasks run by every thread */
+    size_t stolen[GEMM_MAX_THREADS]; /* Tasks taken from the other threads */
+    double busy[GEMM_MAX_THREADS]; /* Seconds from the start of the loop (its publication to the pool) until the thread ran out of tasks */
+} gemm_parallel_stats_t;
+
+/**
+ * Copies the statistics of the last loop run on the thread pool.
+ * Loops which ran on the calling thread only are not recorded.
+ */
+extern void gemm_parallel_get_stats(gemm_parallel_stats_t *stats);
+
+#endif // GEMM_THREAD_H
@@ -0,0 +1,349 @@
+#include "gemm_kernel.h"
+#include "gemm_trace.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Distinct shapes counted per thread, calls of further shapes are counted as untracked.
+ */
+#ifndef GEMM_TRACE_SHAPES
+#define GEMM_TRACE_SHAPES 64
+#endif
+
+_Atomic unsigned gemm_trace_flags;
+
+/**
+ * Entry of the shape histogram of a thread. The key is written before `used` is set and is not changed afterwards.
+ */
+typedef struct trace_slot {
+    _Atomic int used;
+    size_t n;
+    size_t m;
+    size_t k;
+    _Atomic uint64_t calls;
+    _Atomic uint64_t flops;
+    _Atomic uint64_t time_ns;
+} trace_slot_t;
+
+/**
+ * Counters of a thread. Only the owner writes them, with plain load and store pairs instead of atomic
+ * read-modify-write; readers sum up the counters of all threads. The counters are valid while their epoch
+ * equals the global one, gemm_trace_reset advances the global epoch and the owner clears its counters
+ * on its next call. Counters of finished threads are kept and handed over to new threads.
+ */
+typedef struct trace_counters {
+    struct trace_counters *next;
+    _Atomic int owned;
+    _Atomic uint64_t epoch;
+    _Atomic uint64_t calls[GEMM_BACKEND_COUNT];
+    _Atomic uint64_t flops[GEMM_BACKEND_COUNT];
+    _Atomic uint64_t time_ns[GEMM_BACKEND_COUNT];
+    _Atomic uint64_t untracked;
+    trace_slot_t shapes[GEMM_TRACE_SHAPES];
+} trace_counters_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_key_t key;
+    _Atomic(trace_counters_t *) head;
+    _Atomic uint64_t epoch;
+    pthread_rwlock_t callback_lock;
+    gemm_trace_callback_t callback;
+    void *user;
+} trace = {
+    .once = PTHREAD_ONCE_INIT,
+    .callback_lock = PTHREAD_RWLOCK_INITIALIZER,
+};
+
+static __thread trace_counters_t *counters;
+
+static uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static inline void add(_Atomic uint64_t *counter, const uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static void release_counters(void *arg) {
+    trace_counters_t *c = arg;
+    atomic_store(&c->owned, 0);
+}
+
+static void init(void) {
+    pthread_key_create(&trace.key, release_counters);
+}
+
+/**
+ * Counters of the calling thread: the counters of a finished thread or new ones.
+ */
+static trace_counters_t *thread_counters(void) {
+    if (counters != NULL) {
+        return counters;
+    }
+    pthread_once(&trace.once, init);
+
+    trace_counters_t *c = atomic_load(&trace.head);
+    for (; c != NULL; c = c->next) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&c->owned, &expected, 1)) {
+            break;
+        }
+    }
+    if (c == NULL) {
+        c = calloc(1, sizeof(*c));
+        if (c == NULL) {
+            return NULL;
+        }
+        atomic_store(&c->owned, 1);
+        atomic_store(&c->epoch, atomic_load(&trace.epoch));
+        c->next = atomic_load(&trace.head);
+        while (!atomic_compare_exchange_weak(&trace.head, &c->next, c)) {
+        }
+    }
+    pthread_setspecific(trace.key, c);
+    counters = c;
+    return c;
+}
+
+static void clear_counters(trace_counters_t *c) {
+    for (size_t b = 0; b < GEMM_BACKEND_COUNT; b++) {
+        atomic_store_explicit(&c->calls[b], 0, memory_order_relaxed);
+        atomic_store_explicit(&c->flops[b], 0, memory_order_relaxed);
+        atomic_store_explicit(&c->time_ns[b], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&c->untracked, 0, memory_order_relaxed);
+    for (size_t i = 0; i < GEMM_TRACE_SHAPES; i++) {
+        trace_slot_t *slot = &c->shapes[i];
+        atomic_store_explicit(&slot->used, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->flops, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->time_ns, 0, memory_order_relaxed);
+    }
+}
+
+static size_t shape_hash(const size_t n, const size_t m, const size_t k) {
+    size_t hash = (n * 0x9E3779B1u) ^ (m * 0x85EBCA77u) ^ (k * 0xC2B2AE3Du);
+    return hash ^ (hash >> 15);
+}
+
+static uint64_t scope_flops(const gemm_trace_scope_t *scope) {
+    if (scope->problems != NULL) {
+        return gemm_trace_grouped_flops(scope->problems, scope->batch);
+    }
+    return 2 * (uint64_t)scope->n * scope->m * scope->k * scope->batch;
+}
+
+/**
+ * Adds products of one shape to the histogram of the thread.
+ */
+static void count_shape(trace_counters_t *c, const size_t n, const size_t m, const size_t k,
+                        const uint64_t products, const uint64_t flops, const uint64_t time_ns)
+{
+    const size_t start = shape_hash(n, m, k);
+    for (size_t probe = 0; probe < GEMM_TRACE_SHAPES; probe++) {
+        trace_slot_t *slot = &c->shapes[(start + probe) % GEMM_TRACE_SHAPES];
+        if (!atomic_load_explicit(&slot->used, memory_order_relaxed)) {
+            slot->n = n;
+            slot->m = m;
+            slot->k = k;
+            atomic_store_explicit(&slot->used, 1, memory_order_release);
+        } else if ((slot->n != n) || (slot->m != m) || (slot->k != k)) {
+            continue;
+        }
+        add(&slot->calls, products);
+        add(&slot->flops, flops);
+        add(&slot->time_ns, time_ns);
+        return;
+    }
+    add(&c->untracked, products);
+}
+
+static void count_call(const gemm_trace_scope_t *scope, const uint64_t flops, const uint64_t time_ns) {
+    trace_counters_t *c = thread_counters();
+    if (c == NULL) {
+        return;
+    }
+    const uint64_t epoch = atomic_load_explicit(&trace.epoch, memory_order_acquire);
+    if (atomic_load_explicit(&c->epoch, memory_order_relaxed) != epoch) {
+        clear_counters(c);
+        atomic_store_explicit(&c->epoch, epoch, memory_order_release);
+    }
+
+    add(&c->calls[scope->backend], 1);
+    add(&c->flops[scope->backend], flops);
+    add(&c->time_ns[scope->backend], time_ns);
+
+    if (scope->problems == NULL) {
+        count_shape(c, scope->n, scope->m, scope->k, scope->batch, flops, time_ns);
+        return;
+    }
+
+    // The problems of a grouped call run together, the time is split between them in proportion to their FLOPs
+    for (size_t i = 0; i < scope->batch; i++) {
+        const gemm_problem_t *p = &scope->problems[i];
+        const uint64_t problem_flops = 2 * (uint64_t)p->n * p->m * p->k;
+        const uint64_t problem_time = (flops != 0) ? (uint64_t)((double)time_ns * (double)problem_flops / (double)flops)
+                                                   : time_ns / scope->batch;
+        count_shape(c, p->n, p->m, p->k, 1, problem_flops, problem_time);
+    }
+}
+
+extern void gemm_trace_call_begin(gemm_trace_scope_t *scope, const char *entry, const gemm_backend_t backend,
+                                  const size_t n, const size_t m, const size_t k,
+                                  const size_t batch, const gemm_problem_t *problems)
+{
+    scope->entry = entry;
+    scope->backend = (backend == GEMM_BACKEND_AUTO) ? gemm_get_backend() : backend;
+    scope->n = n;
+    scope->m = m;
+    scope->k = k;
+    scope->batch = batch;
+    scope->problems = problems;
+    scope->start_ns = clock_ns();
+}
+
+extern void gemm_trace_call_end(const gemm_trace_scope_t *scope)
+{
+    const uint64_t time_ns = clock_ns() - scope->start_ns;
+    const unsigned flags = atomic_load_explicit(&gemm_trace_flags, memory_order_relaxed);
+    const uint64_t flops = scope_flops(scope);
+
+    if (flags & GEMM_TRACE_STATS) {
+        count_call(scope, flops, time_ns);
+    }
+    if (flags & GEMM_TRACE_CALLBACK) {
+        pthread_rwlock_rdlock(&trace.callback_lock);
+        const gemm_trace_callback_t callback = trace.callback;
+        void *user = trace.user;
+        pthread_rwlock_unlock(&trace.callback_lock);
+
+        if (callback != NULL) {
+            const gemm_trace_event_t event = {
+                .entry = scope->entry,
+                .backend = scope->backend,
+                .n = scope->n,
+                .m = scope->m,
+                .k = scope->k,
+                .batch = scope->batch,
+                .flops = flops,
+                .time_ns = time_ns,
+            };
+            callback(&event, user);
+        }
+    }
+}
+
+extern void gemm_trace_enable(const int enable)
+{
+    if (enable) {
+        atomic_fetch_or(&gemm_trace_flags, GEMM_TRACE_STATS);
+    } else {
+        atomic_fetch_and(&gemm_trace_flags, ~GEMM_TRACE_STATS);
+    }
+}
+
+extern void gemm_trace_set_callback(gemm_trace_callback_t callback, void *user)
+{
+    pthread_rwlock_wrlock(&trace.callback_lock);
+    trace.callback = callback;
+    trace.user = user;
+    pthread_rwlock_unlock(&trace.callback_lock);
+
+    if (callback != NULL) {
+        atomic_fetch_or(&gemm_trace_flags, GEMM_TRACE_CALLBACK);
+    } else {
+        atomic_fetch_and(&gemm_trace_flags, ~GEMM_TRACE_CALLBACK);
+    }
+}
+
+extern void gemm_trace_reset(void)
+{
+    atomic_fetch_add_explicit(&trace.epoch, 1, memory_order_release);
+}
+
+/**
+ * Checks that the counters belong to the current epoch, i.e. were not reset.
+ */
+static int counters_valid(const trace_counters_t *c, const uint64_t epoch) {
+    return atomic_load_explicit(&c->epoch, memory_order_acquire) == epoch;
+}
+
+extern void gemm_trace_get_stats(gemm_trace_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    const uint64_t epoch = atomic_load_explicit(&trace.epoch, memory_order_acquire);
+    for (trace_counters_t *c = atomic_load(&trace.head); c != NULL; c = c->next) {
+        if (!counters_valid(c, epoch)) {
+            continue;
+        }
+        for (size_t b = 0; b < GEMM_BACKEND_COUNT; b++) {
+            stats->calls[b] += atomic_load_explicit(&c->calls[b], memory_order_relaxed);
+            stats->flops[b] += atomic_load_explicit(&c->flops[b], memory_order_relaxed);
+            stats->time_ns[b] += atomic_load_explicit(&c->time_ns[b], memory_order_relaxed);
+        }
+        stats->untracked += atomic_load_explicit(&c->untracked, memory_order_relaxed);
+    }
+}
+
+static int compare_time(const void *a, const void *b) {
+    const gemm_trace_shape_t *x = a;
+    const gemm_trace_shape_t *y = b;
+    return (x->time_ns < y->time_ns) - (x->time_ns > y->time_ns);
+}
+
+extern size_t gemm_trace_get_shapes(gemm_trace_shape_t *shapes, const size_t capacity)
+{
+    const uint64_t epoch = atomic_load_explicit(&trace.epoch, memory_order_acquire);
+    trace_counters_t *head = atomic_load(&trace.head); /* Threads registered later are not included */
+    size_t threads = 0;
+    for (trace_counters_t *c = head; c != NULL; c = c->next) {
+        threads++;
+    }
+    gemm_trace_shape_t *merged = malloc((threads * GEMM_TRACE_SHAPES + 1) * sizeof(*merged));
+    if (merged == NULL) {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (trace_counters_t *c = head; c != NULL; c = c->next) {
+        if (!counters_valid(c, epoch)) {
+            continue;
+        }
+        for (size_t i = 0; i < GEMM_TRACE_SHAPES; i++) {
+            const trace_slot_t *slot = &c->shapes[i];
+            if (!atomic_load_explicit(&slot->used, memory_order_acquire)) {
+                continue;
+            }
+            size_t j = 0;
+            while ((j < count) && ((merged[j].n != slot->n) || (merged[j].m != slot->m) || (merged[j].k != slot->k))) {
+                j++;
+            }
+            if (j == count) {
+                merged[count++] = (gemm_trace_shape_t){.n = slot->n, .m = slot->m, .k = slot->k};
+            }
+            merged[j].calls += atomic_load_explicit(&slot->calls, memory_order_relaxed);
+            merged[j].flops += atomic_load_explicit(&slot->flops, memory_order_relaxed);
+            merged[j].time_ns += atomic_load_explicit(&slot->time_ns, memory_order_relaxed);
+        }
+    }
+
+    // A slot may be claimed before its first call is added
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (merged[i].calls != 0) {
+            merged[kept++] = merged[i];
+        }
+    }
+
+    qsort(merged, kept, sizeof(*merged), compare_time);
+    if (capacity != 0) {
+        memcpy(shapes, merged, MIN(kept, capacity) * sizeof(*merged));
+    }
+    free(merged);
+    return kept;
+}
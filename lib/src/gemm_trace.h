@@ -0,0 +1,88 @@
+#ifndef GEMM_TRACE_H
+#define GEMM_TRACE_H
+
+#include "gemm_perf.h"
+
+#include <stdatomic.h>
+
+/*
+ * Bits of gemm_trace_flags.
+ */
+#define GEMM_TRACE_STATS 1u /* gemm_trace_enable */
+#define GEMM_TRACE_CALLBACK 2u /* gemm_trace_set_callback */
+
+/*
+ * Tracing state checked by every entry point, 0 while tracing is off.
+ */
+extern _Atomic unsigned gemm_trace_flags;
+
+/**
+ * Call of an entry point being traced, entry is NULL if tracing was off when the call started.
+ */
+typedef struct gemm_trace_scope {
+    const char *entry;
+    gemm_backend_t backend;
+    size_t n;
+    size_t m;
+    size_t k;
+    size_t batch; /* Products of the call: n x m x k each, or the problems of a grouped call */
+    const gemm_problem_t *problems; /* Problems of a grouped call, NULL otherwise */
+    uint64_t start_ns;
+} gemm_trace_scope_t;
+
+extern void gemm_trace_call_begin(gemm_trace_scope_t *scope, const char *entry, const gemm_backend_t backend,
+                                  const size_t n, const size_t m, const size_t k,
+                                  const size_t batch, const gemm_problem_t *problems);
+extern void gemm_trace_call_end(const gemm_trace_scope_t *scope);
+
+/**
+ * FLOPs of the products of a grouped call.
+ */
+static inline uint64_t gemm_trace_grouped_flops(const gemm_problem_t *problems, const size_t count)
+{
+    uint64_t flops = 0;
+    for (size_t i = 0; i < count; i++) {
+        flops += 2 * (uint64_t)problems[i].n * problems[i].m * problems[i].k;
+    }
+    return flops;
+}
+
+/*
+ * With tracing off a call costs one relaxed load and a branch.
+ */
+static inline void gemm_trace_begin(gemm_trace_scope_t *scope, const char *entry, const gemm_backend_t backend,
+                                    const size_t n, const size_t m, const size_t k,
+                                    const size_t batch, const gemm_problem_t *problems)
+{
+    scope->entry = NULL;
+    if (__builtin_expect(atomic_load_explicit(&gemm_trace_flags, memory_order_relaxed) != 0, 0)) {
+        gemm_trace_call_begin(scope, entry, backend, n, m, k, batch, problems);
+    }
+}
+
+static inline void gemm_trace_end(const gemm_trace_scope_t *scope)
+{
+    if (__builtin_expect(scope->entry != NULL, 0)) {
+        gemm_trace_call_end(scope);
+    }
+}
+
+/*
+ * Hooks of the public entry points: tracing (gemm_trace_enable, gemm_trace_set_callback) and hardware
+ * event counters (ENABLE_PERF_COUNTERS). GEMM_BACKEND_AUTO records the backend selected at the call.
+ * Batched calls record batch products of one shape, grouped calls every problem with its own shape.
+ */
+#define GEMM_TRACE_BEGIN(backend, n, m, k) GEMM_TRACE_BEGIN_BATCH(backend, n, m, k, 1)
+#define GEMM_TRACE_BEGIN_BATCH(backend, n, m, k, batch) \
+    GEMM_PERF_BEGIN(n, m, k, 2 * (uint64_t)(n) * (m) * (k) * (batch)); \
+    gemm_trace_scope_t gemm_trace_scope_; \
+    gemm_trace_begin(&gemm_trace_scope_, __func__, (backend), (n), (m), (k), (batch), NULL)
+#define GEMM_TRACE_BEGIN_GROUPED(backend, problems, count) \
+    GEMM_PERF_BEGIN(0, 0, 0, gemm_trace_grouped_flops(problems, count)); \
+    gemm_trace_scope_t gemm_trace_scope_; \
+    gemm_trace_begin(&gemm_trace_scope_, __func__, (backend), 0, 0, 0, (count), (problems))
+#define GEMM_TRACE_END() \
+    gemm_trace_end(&gemm_trace_scope_); \
+    GEMM_PERF_END()
+
+#endif // GEMM_TRACE_H
@@ -0,0 +1,609 @@
+#include <qemu-plugin.h>
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+/*
+ * Distinct symbols with separate counters, instructions of further symbols are counted under "[other]".
+ */
+#ifndef PROFILE_SYMBOLS
+#define PROFILE_SYMBOLS 4096
+#endif
+
+/*
+ * vCPUs (threads in user mode) whose calls are followed, instructions of vCPUs beyond the limit
+ * are counted per symbol only.
+ */
+#ifndef PROFILE_VCPUS
+#define PROFILE_VCPUS 256
+#endif
+
+#define PROFILE_ENTRIES 16
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+/**
+ * Instruction classes.
+ */
+typedef enum insn_class {
+    INSN_MLOAD,   /* mld*, msld* - matrix loads */
+    INSN_MSTORE,  /* mst*, msst* - matrix stores */
+    INSN_FMMACC,  /* fmmacc*, fwmmacc* - matrix float multiply-accumulate */
+    INSN_MOTHER,  /* mcfg*, mzero, mmov* and other matrix instructions */
+    INSN_VLOAD,   /* vl* */
+    INSN_VSTORE,  /* vse*, vsse*, vsw* and other vector stores */
+    INSN_VFMA,    /* vfmacc*, vfmadd* and other vector float multiply-adds */
+    INSN_VCONFIG, /* vsetvl* */
+    INSN_VOTHER,  /* Other vector instructions */
+    INSN_LOAD,    /* Scalar loads */
+    INSN_STORE,   /* Scalar stores */
+    INSN_CUSTOM,  /* Custom opcodes the disassembler does not name */
+    INSN_OTHER,
+    INSN_CLASSES
+} insn_class_t;
+
+static const char *class_names[INSN_CLASSES] = {
+    [INSN_MLOAD] = "mld", [INSN_MSTORE] = "mst", [INSN_FMMACC] = "fmmacc", [INSN_MOTHER] = "m-other",
+    [INSN_VLOAD] = "vld", [INSN_VSTORE] = "vst", [INSN_VFMA] = "vfma", [INSN_VCONFIG] = "vsetvl",
+    [INSN_VOTHER] = "v-other", [INSN_LOAD] = "ld", [INSN_STORE] = "st", [INSN_CUSTOM] = "custom",
+    [INSN_OTHER] = "other",
+};
+
+/**
+ * Control transfer ending a translation block.
+ */
+typedef enum transfer {
+    TRANSFER_NONE,
+    TRANSFER_CALL,
+    TRANSFER_RETURN,
+} transfer_t;
+
+/**
+ * Counters of a symbol. counts holds the instructions of the symbol itself, inclusive the instructions
+ * executed between a call of a traced entry point and its return, callees included.
+ */
+typedef struct symbol_stats {
+    const char *name; /* NULL for a free slot */
+    int entry;
+    uint64_t counts[INSN_CLASSES];
+    uint64_t inclusive[INSN_CLASSES];
+} symbol_stats_t;
+
+/**
+ * Instructions of a translation block that belong to one symbol.
+ */
+typedef struct tb_segment {
+    symbol_stats_t *symbol;
+    uint32_t counts[INSN_CLASSES];
+} tb_segment_t;
+
+/**
+ * Translation block summary, built once at translation and passed to the execution callback.
+ */
+typedef struct tb_info {
+    symbol_stats_t *first; /* Symbol of the first instruction */
+    transfer_t transfer;
+    size_t segments;
+    tb_segment_t segment[];
+} tb_info_t;
+
+/**
+ * Traced entry point a vCPU is in, depth counts the calls made from it that have not returned yet.
+ */
+typedef struct vcpu_state {
+    symbol_stats_t *entry;
+    uint64_t depth;
+} vcpu_state_t;
+
+static struct {
+    pthread_mutex_t lock;
+    symbol_stats_t symbols[PROFILE_SYMBOLS];
+    symbol_stats_t other;
+    vcpu_state_t vcpus[PROFILE_VCPUS];
+    const char *entries[PROFILE_ENTRIES];
+    size_t entry_count;
+    unsigned rlen;      /* Matrix register row, bits */
+    unsigned vl;        /* Elements processed by a vector instruction */
+    const char *filter; /* Substring of the symbols reported, NULL for all */
+    FILE *out;
+} profile = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .other = {.name = "[other]"},
+    .rlen = 128,
+    .vl = 4,
+};
+
+static int has_prefix(const char *str, const char *prefix) {
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+static int starts_with_any(const char *str, const char *const *prefixes, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (has_prefix(str, prefixes[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int equals_any(const char *str, const char *const *names, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(str, names[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#define COUNT_OF(array) (sizeof(array) / sizeof((array)[0]))
+
+/**
+ * Checks the base of a vector store mnemonic (up to the first dot): the RVV 0.7 forms (vsw, vsse, vsxe, ...)
+ * and the 1.0 ones (vse32, vsse32, vsuxei32, vs1r, vsm). Arithmetic like vsext, vssub, vsll has other bases.
+ */
+static int is_vector_store(const char *base) {
+    static const char *const stores[] = {
+        "vsb", "vsh", "vsw", "vse", "vssb", "vssh", "vssw", "vsse", "vsxb", "vsxh", "vsxw", "vsxe",
+        "vsuxb", "vsuxh", "vsuxw", "vsuxe", "vsm",
+    };
+    static const char *const indexed[] = {"vsuxei", "vsoxei", "vsxei"};
+
+    if (equals_any(base, stores, COUNT_OF(stores)) || starts_with_any(base, indexed, COUNT_OF(indexed))) {
+        return 1;
+    }
+    // vse<eew>, vsse<eew>, vsseg<nf>e<eew>, vs<nf>r
+    if (has_prefix(base, "vse") && isdigit((unsigned char)base[3])) {
+        return 1;
+    }
+    if ((has_prefix(base, "vsse") && isdigit((unsigned char)base[4])) || has_prefix(base, "vsseg")) {
+        return 1;
+    }
+    return (base[2] != '\0') && isdigit((unsigned char)base[2]) && (base[0] == 'v') && (base[1] == 's')
+           && (base[strlen(base) - 1] == 'r');
+}
+
+/**
+ * Class of an instruction by its mnemonic.
+ */
+static insn_class_t classify_mnemonic(const char *mnemonic) {
+    // Compressed forms count as their full ones
+    const char *name = has_prefix(mnemonic, "c.") ? mnemonic + 2 : mnemonic;
+    char base[32];
+    const size_t len = MIN(strcspn(name, "."), sizeof(base) - 1);
+    memcpy(base, name, len);
+    base[len] = '\0';
+
+    static const char *const mloads[] = {"mld", "msld", "mlae", "mlbe", "mlce", "mlme"};
+    static const char *const mstores[] = {"mst", "msst", "msae", "msbe", "msce", "msme"};
+    static const char *const fmmacc[] = {"fmmacc", "fwmmacc"};
+    static const char *const scalar_m[] = {"mul", "mv", "mret", "max", "min"};
+    static const char *const vfma[] = {
+        "vfmacc", "vfmadd", "vfnmacc", "vfnmadd", "vfmsac", "vfmsub", "vfnmsac", "vfnmsub", "vfwmacc", "vfwnmacc",
+        "vfwmsac", "vfwnmsac",
+    };
+    static const char *const loads[] = {"lb", "lh", "lw", "ld", "lbu", "lhu", "lwu", "flh", "flw", "fld",
+                                        "lwsp", "ldsp", "flwsp", "fldsp"};
+    static const char *const stores[] = {"sb", "sh", "sw", "sd", "fsh", "fsw", "fsd", "swsp", "sdsp", "fswsp", "fsdsp"};
+
+    if (starts_with_any(base, mloads, COUNT_OF(mloads))) {
+        return INSN_MLOAD;
+    }
+    if (starts_with_any(base, mstores, COUNT_OF(mstores))) {
+        return INSN_MSTORE;
+    }
+    if (starts_with_any(base, fmmacc, COUNT_OF(fmmacc))) {
+        return INSN_FMMACC;
+    }
+    if ((base[0] == 'm') && !starts_with_any(base, scalar_m, COUNT_OF(scalar_m))) {
+        return INSN_MOTHER;
+    }
+    if (base[0] == 'v') {
+        if (has_prefix(base, "vsetvl") || has_prefix(base, "vsetivl")) {
+            return INSN_VCONFIG;
+        }
+        if (has_prefix(base, "vl")) {
+            return INSN_VLOAD;
+        }
+        if (is_vector_store(base)) {
+            return INSN_VSTORE;
+        }
+        if (equals_any(base, vfma, COUNT_OF(vfma))) {
+            return INSN_VFMA;
+        }
+        return INSN_VOTHER;
+    }
+    if (equals_any(base, loads, COUNT_OF(loads))) {
+        return INSN_LOAD;
+    }
+    if (equals_any(base, stores, COUNT_OF(stores))) {
+        return INSN_STORE;
+    }
+    return INSN_OTHER;
+}
+
+/**
+ * Class of an instruction the disassembler does not name, from its major opcode.
+ * Vector loads and stores share LOAD-FP and STORE-FP with flw/fsw and differ in the width field.
+ */
+static insn_class_t classify_opcode(const uint32_t bits, const size_t size) {
+    if (size != 4) {
+        return INSN_OTHER;
+    }
+    const uint32_t opcode = bits & 0x7f;
+    const uint32_t width = (bits >> 12) & 0x7;
+    const int vector_width = (width == 0) || (width >= 5);
+    switch (opcode) {
+    case 0x07:
+        return vector_width ? INSN_VLOAD : INSN_LOAD;
+    case 0x27:
+        return vector_width ? INSN_VSTORE : INSN_STORE;
+    case 0x57:
+        return (width == 7) ? INSN_VCONFIG : INSN_VOTHER;
+    case 0x0b: /* custom-0 */
+    case 0x2b: /* custom-1 */
+    case 0x5b: /* custom-2 */
+    case 0x7b: /* custom-3 */
+        return INSN_CUSTOM;
+    default:
+        return INSN_OTHER;
+    }
+}
+
+/**
+ * Raw bits of an instruction, 2 or 4 bytes.
+ */
+static uint32_t insn_bits(const struct qemu_plugin_insn *insn, size_t *size) {
+    uint32_t bits = 0;
+    *size = MIN(qemu_plugin_insn_size(insn), sizeof(bits));
+#if QEMU_PLUGIN_VERSION >= 3
+    qemu_plugin_insn_data(insn, &bits, *size);
+#else
+    memcpy(&bits, qemu_plugin_insn_data(insn), *size);
+#endif
+    return bits;
+}
+
+/**
+ * Calls and returns by the RISC-V conventions: jal/jalr linking ra or t0 is a call,
+ * jalr x0 through ra or t0 (ret, c.jr ra) a return. Tail calls link nothing and are neither.
+ */
+static transfer_t classify_transfer(const uint32_t bits, const size_t size) {
+    if (size == 2) {
+        const uint32_t funct4 = (bits >> 12) & 0xf;
+        const uint32_t rs1 = (bits >> 7) & 0x1f;
+        const uint32_t rs2 = (bits >> 2) & 0x1f;
+        if (((bits & 0x3) != 0x2) || (rs2 != 0) || (rs1 == 0)) {
+            return TRANSFER_NONE;
+        }
+        if (funct4 == 0x9) {
+            return TRANSFER_CALL; /* c.jalr */
+        }
+        return ((funct4 == 0x8) && ((rs1 == 1) || (rs1 == 5))) ? TRANSFER_RETURN : TRANSFER_NONE; /* c.jr */
+    }
+
+    const uint32_t opcode = bits & 0x7f;
+    const uint32_t rd = (bits >> 7) & 0x1f;
+    const uint32_t rs1 = (bits >> 15) & 0x1f;
+    const int rd_link = (rd == 1) || (rd == 5);
+    if (opcode == 0x6f) {
+        return rd_link ? TRANSFER_CALL : TRANSFER_NONE;
+    }
+    if (opcode == 0x67) {
+        if (rd_link) {
+            return TRANSFER_CALL;
+        }
+        return ((rd == 0) && ((rs1 == 1) || (rs1 == 5))) ? TRANSFER_RETURN : TRANSFER_NONE;
+    }
+    return TRANSFER_NONE;
+}
+
+/**
+ * Mnemonic from a disassembled instruction. The RISC-V disassembler of QEMU puts the raw bits
+ * (4 or 8 hex digits) before the mnemonic.
+ */
+static void disas_mnemonic(const char *disas, char *mnemonic, const size_t size) {
+    const char *p = disas + strspn(disas, " \t");
+    size_t len = strcspn(p, " \t");
+    const char *next = p + len + strspn(p + len, " \t");
+    if (((len == 4) || (len == 8)) && (strspn(p, "0123456789abcdef") == len) && (*next != '\0')) {
+        p = next;
+        len = strcspn(p, " \t");
+    }
+    len = MIN(len, size - 1);
+    memcpy(mnemonic, p, len);
+    mnemonic[len] = '\0';
+}
+
+static insn_class_t classify(const struct qemu_plugin_insn *insn, const uint32_t bits, const size_t size) {
+    char *disas = qemu_plugin_insn_disas(insn);
+    char mnemonic[32] = "";
+    if (disas != NULL) {
+        disas_mnemonic(disas, mnemonic, sizeof(mnemonic));
+        free(disas);
+    }
+    if ((mnemonic[0] == '\0') || has_prefix(mnemonic, "illegal") || has_prefix(mnemonic, ".insn")
+        || has_prefix(mnemonic, "unknown")) {
+        return classify_opcode(bits, size);
+    }
+    return classify_mnemonic(mnemonic);
+}
+
+static size_t name_hash(const char *name) {
+    size_t hash = 5381;
+    for (; *name != '\0'; name++) {
+        hash = (hash * 33) ^ (unsigned char)*name;
+    }
+    return hash;
+}
+
+/**
+ * Counters of a symbol, called under the lock. Symbol names point to the symbol table of the guest
+ * binary and stay valid, instructions without a symbol are counted under "[unknown]".
+ */
+static symbol_stats_t *find_symbol(const char *name) {
+    if (name == NULL) {
+        name = "[unknown]";
+    }
+    const size_t start = name_hash(name) % PROFILE_SYMBOLS;
+    for (size_t probe = 0; probe < PROFILE_SYMBOLS; probe++) {
+        symbol_stats_t *slot = &profile.symbols[(start + probe) % PROFILE_SYMBOLS];
+        if (slot->name == NULL) {
+            slot->name = name;
+            for (size_t e = 0; e < profile.entry_count; e++) {
+                slot->entry |= strcmp(name, profile.entries[e]) == 0;
+            }
+            return slot;
+        }
+        if (strcmp(slot->name, name) == 0) {
+            return slot;
+        }
+    }
+    return &profile.other;
+}
+
+static void add(uint64_t *counter, const uint64_t value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static void vcpu_tb_exec(unsigned int vcpu_index, void *userdata) {
+    const tb_info_t *tb = userdata;
+    vcpu_state_t *vcpu = (vcpu_index < PROFILE_VCPUS) ? &profile.vcpus[vcpu_index] : NULL;
+
+    if ((vcpu != NULL) && (vcpu->entry == NULL) && tb->first->entry) {
+        vcpu->entry = tb->first;
+        vcpu->depth = 0;
+    }
+    symbol_stats_t *entry = (vcpu != NULL) ? vcpu->entry : NULL;
+
+    for (size_t s = 0; s < tb->segments; s++) {
+        const tb_segment_t *segment = &tb->segment[s];
+        for (size_t c = 0; c < INSN_CLASSES; c++) {
+            if (segment->counts[c] != 0) {
+                add(&segment->symbol->counts[c], segment->counts[c]);
+                if (entry != NULL) {
+                    add(&entry->inclusive[c], segment->counts[c]);
+                }
+            }
+        }
+    }
+
+    if (entry != NULL) {
+        if (tb->transfer == TRANSFER_CALL) {
+            vcpu->depth++;
+        } else if (tb->transfer == TRANSFER_RETURN) {
+            if (vcpu->depth == 0) {
+                vcpu->entry = NULL;
+            } else {
+                vcpu->depth--;
+            }
+        }
+    }
+}
+
+/**
+ * Classifies the instructions of a new translation block. Only the last instruction of a block
+ * transfers control, so the call depth is updated once per execution.
+ */
+static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb) {
+    (void)id;
+    const size_t n_insns = qemu_plugin_tb_n_insns(tb);
+    if (n_insns == 0) {
+        return;
+    }
+    tb_info_t *info = calloc(1, sizeof(*info) + (n_insns * sizeof(tb_segment_t)));
+    if (info == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&profile.lock);
+    for (size_t i = 0; i < n_insns; i++) {
+        const struct qemu_plugin_insn *insn = qemu_plugin_tb_get_insn(tb, i);
+        symbol_stats_t *symbol = find_symbol(qemu_plugin_insn_symbol(insn));
+        if ((info->segments == 0) || (info->segment[info->segments - 1].symbol != symbol)) {
+            info->segment[info->segments++].symbol = symbol;
+        }
+
+        size_t size;
+        const uint32_t bits = insn_bits(insn, &size);
+        info->segment[info->segments - 1].counts[classify(insn, bits, size)]++;
+        if (i == 0) {
+            info->first = symbol;
+        }
+        if (i == n_insns - 1) {
+            info->transfer = classify_transfer(bits, size);
+        }
+    }
+    pthread_mutex_unlock(&profile.lock);
+
+    qemu_plugin_register_vcpu_tb_exec_cb(tb, vcpu_tb_exec, QEMU_PLUGIN_CB_NO_REGS, info);
+}
+
+static uint64_t total(const uint64_t *counts) {
+    uint64_t sum = 0;
+    for (size_t c = 0; c < INSN_CLASSES; c++) {
+        sum += counts[c];
+    }
+    return sum;
+}
+
+static uint64_t vector_and_matrix(const uint64_t *counts) {
+    return counts[INSN_MLOAD] + counts[INSN_MSTORE] + counts[INSN_FMMACC] + counts[INSN_MOTHER] + counts[INSN_VLOAD]
+           + counts[INSN_VSTORE] + counts[INSN_VFMA] + counts[INSN_VCONFIG] + counts[INSN_VOTHER];
+}
+
+/**
+ * Prints a row of counters with the derived ratios:
+ * - FLOP: fmmacc on full tiles (rows = cols = rlen / 32, k = rlen / 32 floats) and vector FMAs on vl elements,
+ * - mem/kFLOP: load and store instructions of all kinds per thousand FLOPs,
+ * - FLOP/B: FLOPs per byte moved by matrix and vector loads and stores (full rows, vl floats),
+ * - fmmacc/mld and vfma/vld: multiply-adds per register load,
+ * - mix: shares of matrix, vector and scalar memory instructions.
+ */
+static void print_row(const char *name, const char *kind, const uint64_t *counts) {
+    const double rows = (double)profile.rlen / 32.0;
+    const double flops = (double)counts[INSN_FMMACC] * 2.0 * rows * rows * rows
+                         + (double)counts[INSN_VFMA] * 2.0 * profile.vl;
+    const double bytes = (double)(counts[INSN_MLOAD] + counts[INSN_MSTORE]) * rows * (profile.rlen / 8.0)
+                         + (double)(counts[INSN_VLOAD] + counts[INSN_VSTORE]) * profile.vl * sizeof(float);
+    const uint64_t mem = counts[INSN_MLOAD] + counts[INSN_MSTORE] + counts[INSN_VLOAD] + counts[INSN_VSTORE]
+                         + counts[INSN_LOAD] + counts[INSN_STORE];
+    const uint64_t insns = total(counts);
+    const uint64_t matrix = counts[INSN_MLOAD] + counts[INSN_MSTORE] + counts[INSN_FMMACC] + counts[INSN_MOTHER];
+    const uint64_t vector = vector_and_matrix(counts) - matrix;
+
+    fprintf(profile.out, "%-32s %-4s %12" PRIu64, name, kind, insns);
+    for (size_t c = 0; c < INSN_CLASSES; c++) {
+        fprintf(profile.out, " %10" PRIu64, counts[c]);
+    }
+    fprintf(profile.out, " %10.3f %8.3f %12.3f %9.3f %9.3f %6.1f %6.1f %6.1f\n",
+            (flops > 0) ? (double)mem * 1e3 / flops : -1.0,
+            (bytes > 0) ? flops / bytes : -1.0,
+            (counts[INSN_MLOAD] != 0) ? (double)counts[INSN_FMMACC] / (double)counts[INSN_MLOAD] : -1.0,
+            (counts[INSN_VLOAD] != 0) ? (double)counts[INSN_VFMA] / (double)counts[INSN_VLOAD] : -1.0,
+            flops * 1e-6,
+            (insns != 0) ? 100.0 * (double)matrix / (double)insns : 0.0,
+            (insns != 0) ? 100.0 * (double)vector / (double)insns : 0.0,
+            (insns != 0) ? 100.0 * (double)(counts[INSN_LOAD] + counts[INSN_STORE]) / (double)insns : 0.0);
+}
+
+static int compare_symbols(const void *a, const void *b) {
+    const symbol_stats_t *x = *(const symbol_stats_t *const *)a;
+    const symbol_stats_t *y = *(const symbol_stats_t *const *)b;
+    const uint64_t tx = total(x->counts);
+    const uint64_t ty = total(y->counts);
+    return (tx < ty) - (tx > ty);
+}
+
+/**
+ * Prints the traced entry points with their callees (incl) and the symbols running matrix or vector
+ * instructions (self), sorted by the instructions executed.
+ */
+static void plugin_exit(qemu_plugin_id_t id, void *userdata) {
+    (void)id;
+    (void)userdata;
+    symbol_stats_t **sorted = malloc((PROFILE_SYMBOLS + 1) * sizeof(*sorted));
+    if (sorted == NULL) {
+        return;
+    }
+    size_t count = 0;
+    for (size_t s = 0; s < PROFILE_SYMBOLS; s++) {
+        symbol_stats_t *symbol = &profile.symbols[s];
+        if ((symbol->name != NULL) && (total(symbol->counts) != 0)) {
+            sorted[count++] = symbol;
+        }
+    }
+    if (total(profile.other.counts) != 0) {
+        sorted[count++] = &profile.other;
+    }
+    qsort(sorted, count, sizeof(*sorted), compare_symbols);
+
+    fprintf(profile.out, "# fmmacc on %ux%ux%u float tiles, vector instructions on %u floats\n",
+            profile.rlen / 32, profile.rlen / 32, profile.rlen / 32, profile.vl);
+    fprintf(profile.out, "%-32s %-4s %12s", "symbol", "kind", "insns");
+    for (size_t c = 0; c < INSN_CLASSES; c++) {
+        fprintf(profile.out, " %10s", class_names[c]);
+    }
+    fprintf(profile.out, " %10s %8s %12s %9s %9s %6s %6s %6s\n", "mem/kFLOP", "FLOP/B", "fmmacc/mld", "vfma/vld",
+            "MFLOP", "mat %", "vec %", "mem %");
+
+    for (size_t e = 0; e < profile.entry_count; e++) {
+        for (size_t s = 0; s < count; s++) {
+            if (sorted[s]->entry && (strcmp(sorted[s]->name, profile.entries[e]) == 0)) {
+                print_row(sorted[s]->name, "incl", sorted[s]->inclusive);
+            }
+        }
+    }
+    uint64_t all[INSN_CLASSES] = {0};
+    for (size_t s = 0; s < count; s++) {
+        const symbol_stats_t *symbol = sorted[s];
+        for (size_t c = 0; c < INSN_CLASSES; c++) {
+            all[c] += symbol->counts[c];
+        }
+        const int matched = (profile.filter != NULL) ? (strstr(symbol->name, profile.filter) != NULL)
+                                                     : (vector_and_matrix(symbol->counts) != 0);
+        if (matched) {
+            print_row(symbol->name, "self", symbol->counts);
+        }
+    }
+    print_row("[total]", "self", all);
+    free(sorted);
+
+    if (profile.out != stderr) {
+        fclose(profile.out);
+    }
+}
+
+/**
+ * Arguments (-plugin libgemm_profile.so,key=value,...):
+ * - entry=<symbol> - entry point counted with its callees, may be repeated
+ *   (gemm_block4x4_rvm and gemm_block4x4_rvv by default),
+ * - filter=<substring> - symbols printed, by default the ones running matrix or vector instructions,
+ * - rlen=<bits> - matrix register row (128 on C907),
+ * - vl=<floats> - elements processed by a vector instruction (4 for VLEN 128 and LMUL 1),
+ * - out=<file> - report file instead of stderr.
+ */
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info, int argc, char **argv) {
+    (void)info;
+    profile.out = stderr;
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        if (has_prefix(arg, "entry=") && (profile.entry_count < PROFILE_ENTRIES)) {
+            profile.entries[profile.entry_count++] = strdup(arg + strlen("entry="));
+        } else if (has_prefix(arg, "filter=")) {
+            profile.filter = strdup(arg + strlen("filter="));
+        } else if (has_prefix(arg, "rlen=")) {
+            profile.rlen = (unsigned)strtoul(arg + strlen("rlen="), NULL, 0);
+        } else if (has_prefix(arg, "vl=")) {
+            profile.vl = (unsigned)strtoul(arg + strlen("vl="), NULL, 0);
+        } else if (has_prefix(arg, "out=")) {
+            FILE *out = fopen(arg + strlen("out="), "w");
+            if (out == NULL) {
+                fprintf(stderr, "gemm_profile: cannot open %s\n", arg + strlen("out="));
+                return -1;
+            }
+            profile.out = out;
+        } else {
+            fprintf(stderr, "gemm_profile: unknown argument %s\n", arg);
+            return -1;
+        }
+    }
+    if ((profile.rlen < 32) || (profile.vl == 0)) {
+        fprintf(stderr, "gemm_profile: rlen must be at least 32 and vl positive\n");
+        return -1;
+    }
+    if (profile.entry_count == 0) {
+        profile.entries[profile.entry_count++] = "gemm_block4x4_rvm";
+        profile.entries[profile.entry_count++] = "gemm_block4x4_rvv";
+    }
+
+    qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
+    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+    return 0;
+}
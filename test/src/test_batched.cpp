@@ -0,0 +1,162 @@
+#include "test_common.hpp"
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+constexpr size_t batchIndex{3U};
+
+template <typename T>
+class GemmBatched : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+    static constexpr size_t batch = std::tuple_element_t<batchIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+};
+
+#define TEST_BATCH(n, m, k, batch)                                                                  \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>,            \
+               std::integral_constant<size_t, (k)>, std::integral_constant<size_t, (batch)>>
+
+using TypesBatched = testing::Types<
+                                    TEST_BATCH(1U, 1U, 1U, 1U),
+                                    TEST_BATCH(4U, 4U, 4U, 3U),
+                                    TEST_BATCH(5U, 7U, 3U, 17U),
+                                    TEST_BATCH(13U, 11U, 19U, 9U),
+                                    TEST_BATCH(64U, 64U, 64U, 33U),
+                                    // More products than described at once
+                                    TEST_BATCH(3U, 5U, 7U, 300U),
+                                    // Few large products
+                                    TEST_BATCH(131U, 517U, 519U, 2U)>;
+
+TYPED_TEST_CASE(GemmBatched, TypesBatched);
+
+TYPED_TEST(GemmBatched, Rand_ABC_Batched)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+    const size_t batch = TestFixture::batch;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    std::vector<VectorType> A(batch, VectorType(n*m));
+    std::vector<VectorType> B(batch, VectorType(m*k));
+    std::vector<VectorType> C_ref(batch, VectorType(n*k));
+    std::vector<VectorType> C_comp(batch, VectorType(n*k));
+    std::vector<const float *> A_ptr(batch);
+    std::vector<const float *> B_ptr(batch);
+    std::vector<float *> C_ptr(batch);
+
+    for (size_t i = 0; i < batch; i++) {
+        std::generate(A[i].begin(), A[i].end(), [&] { return dist(rng); });
+        std::generate(B[i].begin(), B[i].end(), [&] { return dist(rng); });
+        std::generate(C_ref[i].begin(), C_ref[i].end(), [&] { return dist(rng); });
+        C_comp[i] = C_ref[i];
+        A_ptr[i] = A[i].data();
+        B_ptr[i] = B[i].data();
+        C_ptr[i] = C_comp[i].data();
+
+        gemm_ref(A[i].data(), B[i].data(), C_ref[i].data(), n, m, k);
+    }
+
+    gemm_batched(A_ptr.data(), B_ptr.data(), C_ptr.data(), n, m, k, batch);
+
+    for (size_t i = 0; i < batch; i++) {
+        ASSERT_TRUE(AssertMatricesEqual(C_ref[i].data(), C_comp[i].data(), n, k, threshold)) << "batch index " << i;
+    }
+}
+
+TYPED_TEST(GemmBatched, Rand_ABC_StridedBatched)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+    const size_t batch = TestFixture::batch;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    // Matrices are placed with gaps between them
+    const size_t strideA = n*m + 5;
+    const size_t strideC = n*k + 3;
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    VectorType A(strideA * batch);
+    VectorType B(m*k);
+    VectorType C_ref(strideC * batch);
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    std::generate(C_ref.begin(), C_ref.end(), [&] { return dist(rng); });
+    VectorType C_comp(C_ref);
+
+    for (size_t i = 0; i < batch; i++) {
+        gemm_ref(&A[i * strideA], B.data(), &C_ref[i * strideC], n, m, k);
+    }
+
+    // The same B for all products
+    gemm_strided_batched(A.data(), strideA, B.data(), 0, C_comp.data(), strideC, n, m, k, batch);
+
+    for (size_t i = 0; i < batch; i++) {
+        ASSERT_TRUE(AssertMatricesEqual(&C_ref[i * strideC], &C_comp[i * strideC], n, k, threshold)) << "batch index " << i;
+    }
+}
+
+TYPED_TEST(GemmBatched, Rand_ABC_StridedBatched_Threads)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+    const size_t batch = TestFixture::batch;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    VectorType A(n*m * batch);
+    VectorType B(m*k * batch);
+    VectorType C_init(n*k * batch);
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    std::generate(C_init.begin(), C_init.end(), [&] { return dist(rng); });
+    VectorType C_ref(C_init);
+    VectorType C_comp(C_init.size());
+
+    for (size_t i = 0; i < batch; i++) {
+        gemm_ref(&A[i * n*m], &B[i * m*k], &C_ref[i * n*k], n, m, k);
+    }
+
+    const size_t parallel_threshold = gemm_get_parallel_threshold();
+    gemm_set_parallel_threshold(0);
+    for (const size_t threads : {1U, 2U, 4U}) {
+        std::copy(C_init.begin(), C_init.end(), C_comp.begin());
+
+        gemm_set_num_threads(threads);
+        gemm_strided_batched(A.data(), n*m, B.data(), m*k, C_comp.data(), n*k, n, m, k, batch);
+
+        ASSERT_TRUE(AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k * batch, threshold)) << "threads = " << threads;
+    }
+    gemm_set_num_threads(0);
+    gemm_set_parallel_threshold(parallel_threshold);
+}
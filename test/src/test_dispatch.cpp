@@ -0,0 +1,232 @@
+#include "test_common.hpp"
+
+#include <cstdio>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+
+template <typename T>
+class GemmDispatch : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+
+    /**
+     * Checks gemm with the currently selected backend against gemm_ref.
+     */
+    static ::testing::AssertionResult Check()
+    {
+        VectorType A(n*m, 0.0f);
+        VectorType B(m*k, 0.0f);
+        VectorType C_ref(n*k, 0.0f);
+        VectorType C_comp(n*k, 0.0f);
+
+        std::mt19937 rng;
+        rng.seed(std::random_device()());
+        std::uniform_real_distribution<ElemType> dist(0, 100);
+
+        std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+        std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+        std::generate(C_ref.begin(), C_ref.end(), [&] { return dist(rng); });
+        std::copy(C_ref.begin(), C_ref.end(), C_comp.begin());
+
+        gemm_ref(A.data(), B.data(), C_ref.data(), n, m, k);
+        gemm(A.data(), B.data(), C_comp.data(), n, m, k);
+
+        const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+        return AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold);
+    }
+};
+
+#define TEST_GEMM(n, m, k) \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>, std::integral_constant<size_t, (k)>>
+
+using TypesDispatch = testing::Types<
+                                     TEST_GEMM(1U, 1U, 1U),
+                                     TEST_GEMM(5U, 7U, 3U),
+                                     TEST_GEMM(16U, 16U, 16U),
+                                     TEST_GEMM(67U, 300U, 45U),
+                                     // Test several macro blocks of the driver
+                                     TEST_GEMM(131U, 517U, 519U)>;
+
+TYPED_TEST_CASE(GemmDispatch, TypesDispatch);
+
+TYPED_TEST(GemmDispatch, Rand_ABC_Selected)
+{
+    ASSERT_TRUE(TestFixture::Check()) << "backend = " << gemm_get_backend();
+}
+
+TYPED_TEST(GemmDispatch, Rand_ABC_Strategies)
+{
+    for (const gemm_strategy_t strategy : {GEMM_STRATEGY_UNPACKED, GEMM_STRATEGY_GEMV, GEMM_STRATEGY_BLOCKED,
+                                           GEMM_STRATEGY_RECURSIVE}) {
+        gemm_rule_t rule{};
+        rule.strategy = strategy;
+        rule.backend = GEMM_BACKEND_AUTO;
+        // Odd panel sizes are rounded up to the register blocks
+        rule.mc = 13;
+        rule.kc = 37;
+        rule.nc = 29;
+        rule.threads = 2;
+        ASSERT_EQ(gemm_set_rules(&rule, 1), 0);
+        ASSERT_TRUE(TestFixture::Check()) << "strategy = " << strategy;
+    }
+    ASSERT_EQ(gemm_set_rules(nullptr, 0), 0);
+}
+
+TYPED_TEST(GemmDispatch, Rand_ABC_Backends)
+{
+    const gemm_backend_t selected = gemm_get_backend();
+    for (const gemm_backend_t backend : {GEMM_BACKEND_REF, GEMM_BACKEND_RVV, GEMM_BACKEND_RVM}) {
+        if (gemm_set_backend(backend) != 0) {
+            // Not built for this target or not supported by the hart
+            continue;
+        }
+        ASSERT_EQ(gemm_get_backend(), backend);
+        ASSERT_TRUE(TestFixture::Check()) << "backend = " << backend;
+    }
+    ASSERT_EQ(gemm_set_backend(selected), 0);
+}
+
+TEST(GemmDispatch, SetBackend)
+{
+    const gemm_backend_t selected = gemm_get_backend();
+
+    // The scalar backend runs on any hart
+    ASSERT_EQ(gemm_set_backend(GEMM_BACKEND_REF), 0);
+    ASSERT_EQ(gemm_get_backend(), GEMM_BACKEND_REF);
+
+    // An unknown backend does not change the selection
+    ASSERT_EQ(gemm_set_backend(static_cast<gemm_backend_t>(42)), -1);
+    ASSERT_EQ(gemm_get_backend(), GEMM_BACKEND_REF);
+
+    ASSERT_EQ(gemm_set_backend(selected), 0);
+    ASSERT_EQ(gemm_get_backend(), selected);
+}
+
+TEST(GemmDispatch, DefaultRules)
+{
+    ASSERT_EQ(gemm_set_rules(nullptr, 0), 0);
+    EXPECT_EQ(gemm_get_rule(4, 4, 4).strategy, GEMM_STRATEGY_UNPACKED);
+    EXPECT_EQ(gemm_get_rule(1, 1000, 1000).strategy, GEMM_STRATEGY_GEMV);
+    EXPECT_EQ(gemm_get_rule(1000, 1000, 1).strategy, GEMM_STRATEGY_GEMV);
+    EXPECT_EQ(gemm_get_rule(256, 256, 256).strategy, GEMM_STRATEGY_BLOCKED);
+}
+
+TEST(GemmDispatch, SetRules)
+{
+    gemm_rule_t rules[2]{};
+    rules[0].max_n = 8;
+    rules[0].max_k = 8;
+    rules[0].strategy = GEMM_STRATEGY_GEMV;
+    rules[0].backend = GEMM_BACKEND_AUTO;
+    rules[1].max_work = 1000;
+    rules[1].strategy = GEMM_STRATEGY_UNPACKED;
+    rules[1].backend = GEMM_BACKEND_AUTO;
+    ASSERT_EQ(gemm_set_rules(rules, 2), 0);
+
+    // The first matching rule wins, shapes no rule matches use the blocked driver
+    EXPECT_EQ(gemm_get_rule(8, 100, 8).strategy, GEMM_STRATEGY_GEMV);
+    EXPECT_EQ(gemm_get_rule(9, 100, 1).strategy, GEMM_STRATEGY_UNPACKED);
+    EXPECT_EQ(gemm_get_rule(9, 100, 9).strategy, GEMM_STRATEGY_BLOCKED);
+    EXPECT_EQ(gemm_get_rule(9, 100, 9).backend, GEMM_BACKEND_AUTO);
+
+    // Invalid tables do not change the rules
+    std::vector<gemm_rule_t> many(GEMM_MAX_RULES + 1, rules[0]);
+    EXPECT_EQ(gemm_set_rules(many.data(), many.size()), -1);
+    rules[1].strategy = static_cast<gemm_strategy_t>(42);
+    EXPECT_EQ(gemm_set_rules(rules, 2), -1);
+    EXPECT_EQ(gemm_get_rule(9, 100, 1).strategy, GEMM_STRATEGY_UNPACKED);
+
+    ASSERT_EQ(gemm_set_rules(nullptr, 0), 0);
+    EXPECT_EQ(gemm_get_rule(8, 100, 8).strategy, GEMM_STRATEGY_BLOCKED);
+}
+
+TEST(GemmDispatch, SetRulesWhileReading)
+{
+    // Every table maps the 8x8x8 product to a single strategy, readers see one table or the other
+    gemm_rule_t gemv{};
+    gemv.max_work = 1000;
+    gemv.strategy = GEMM_STRATEGY_GEMV;
+    gemv.backend = GEMM_BACKEND_AUTO;
+    gemm_rule_t unpacked = gemv;
+    unpacked.strategy = GEMM_STRATEGY_UNPACKED;
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; t++) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                const gemm_strategy_t strategy = gemm_get_rule(8, 8, 8).strategy;
+                if ((strategy != GEMM_STRATEGY_GEMV) && (strategy != GEMM_STRATEGY_UNPACKED)) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (size_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(gemm_set_rules((i % 2 == 0) ? &gemv : &unpacked, 1), 0);
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0U);
+
+    ASSERT_EQ(gemm_set_rules(nullptr, 0), 0);
+}
+
+TEST(GemmDispatch, LoadRules)
+{
+    char path[] = "/tmp/rmvgemm_configXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+
+    std::FILE *file = std::fopen(path, "w");
+    ASSERT_NE(file, nullptr);
+    std::fputs("# strategy and bounds\n"
+               "\n"
+               "gemv max_n=4 threads=2 # row vectors\n"
+               "recursive max_k=64 backend=ref\n"
+               "blocked max_work=1000000 backend=ref mc=32 kc=128 nc=256\n", file);
+    std::fclose(file);
+
+    ASSERT_EQ(gemm_load_rules(path), 0);
+    const gemm_rule_t gemv = gemm_get_rule(4, 1000, 1000);
+    EXPECT_EQ(gemv.strategy, GEMM_STRATEGY_GEMV);
+    EXPECT_EQ(gemv.max_n, 4U);
+    EXPECT_EQ(gemv.threads, 2U);
+    EXPECT_EQ(gemv.backend, GEMM_BACKEND_AUTO);
+    const gemm_rule_t recursive = gemm_get_rule(100, 100, 64);
+    EXPECT_EQ(recursive.strategy, GEMM_STRATEGY_RECURSIVE);
+    EXPECT_EQ(recursive.backend, GEMM_BACKEND_REF);
+    const gemm_rule_t blocked = gemm_get_rule(100, 100, 100);
+    EXPECT_EQ(blocked.strategy, GEMM_STRATEGY_BLOCKED);
+    EXPECT_EQ(blocked.backend, GEMM_BACKEND_REF);
+    EXPECT_EQ(blocked.mc, 32U);
+    EXPECT_EQ(blocked.kc, 128U);
+    EXPECT_EQ(blocked.nc, 256U);
+
+    file = std::fopen(path, "w");
+    ASSERT_NE(file, nullptr);
+    std::fputs("blocked mc=-1\n", file);
+    std::fclose(file);
+    EXPECT_EQ(gemm_load_rules(path), -1);
+    EXPECT_EQ(gemm_load_rules("/nonexistent/rmvgemm.conf"), -1);
+    EXPECT_EQ(gemm_get_rule(4, 1000, 1000).strategy, GEMM_STRATEGY_GEMV);
+
+    std::remove(path);
+    ASSERT_EQ(gemm_set_rules(nullptr, 0), 0);
+}
@@ -0,0 +1,169 @@
+#include "test_common.hpp"
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+
+using EpilogueFunc = void (*)(const float *, const float *, float *, const size_t, const size_t, const size_t,
+                              const gemm_epilogue_t *);
+
+template <typename T>
+class Epilogue : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+
+    static ElemType Activate(gemm_activation_t activation, ElemType x)
+    {
+        switch (activation) {
+        case GEMM_ACTIVATION_RELU:
+            return std::max(x, 0.0f);
+        case GEMM_ACTIVATION_GELU:
+            return static_cast<ElemType>(0.5 * x * (1.0 + std::tanh(std::sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x))));
+        default:
+            return x;
+        }
+    }
+
+    /**
+     * Checks C = act(alpha * A * B + beta * C + col_bias + row_bias) of func against gemm_ref
+     * followed by the epilogue computed element by element.
+     * Elements are in [-1, 1], so that the activations see both signs.
+     */
+    static ::testing::AssertionResult Check(EpilogueFunc func, ElemType alpha, ElemType beta,
+                                            bool rowBias, bool colBias, gemm_activation_t activation)
+    {
+        std::mt19937 rng;
+        rng.seed(std::random_device()());
+        std::uniform_real_distribution<ElemType> dist(-1, 1);
+
+        VectorType A(n*m, 0.0f);
+        VectorType B(m*k, 0.0f);
+        VectorType C(n*k, 0.0f);
+        VectorType rowBiasData(n, 0.0f);
+        VectorType colBiasData(k, 0.0f);
+        std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+        std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+        std::generate(C.begin(), C.end(), [&] { return dist(rng); });
+        std::generate(rowBiasData.begin(), rowBiasData.end(), [&] { return dist(rng); });
+        std::generate(colBiasData.begin(), colBiasData.end(), [&] { return dist(rng); });
+
+        VectorType product(n*k, 0.0f);
+        gemm_ref(A.data(), B.data(), product.data(), n, m, k);
+        VectorType C_ref(n*k, 0.0f);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < k; j++) {
+                ElemType x = alpha * product[i * k + j] + ((beta == 0.0f) ? 0.0f : beta * C[i * k + j]);
+                x += (colBias ? colBiasData[j] : 0.0f) + (rowBias ? rowBiasData[i] : 0.0f);
+                C_ref[i * k + j] = Activate(activation, x);
+            }
+        }
+
+        if (beta == 0.0f) {
+            // C must not be read
+            std::fill(C.begin(), C.end(), std::numeric_limits<ElemType>::quiet_NaN());
+        }
+
+        const gemm_epilogue_t epilogue = {
+            alpha,
+            beta,
+            rowBias ? rowBiasData.data() : nullptr,
+            colBias ? colBiasData.data() : nullptr,
+            activation,
+        };
+        func(A.data(), B.data(), C.data(), n, m, k, &epilogue);
+
+        // Results close to zero make a relative error meaningless, the absolute one is bounded
+        // by the rounding of the m products.
+        const ElemType tolerance = std::numeric_limits<ElemType>::epsilon() * (m + 2) * (m + 4);
+        for (size_t i = 0; i < n*k; i++) {
+            if (!(std::abs(C_ref[i] - C[i]) <= tolerance)) {
+                return ::testing::AssertionFailure() << "Difference at position (" << i / k << ", " << i % k << ")"
+                                                     << ". Expected: " << C_ref[i] << ", Actual: " << C[i];
+            }
+        }
+        return ::testing::AssertionSuccess();
+    }
+};
+
+#define TEST_GEMM(n, m, k) \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>, std::integral_constant<size_t, (k)>>
+
+using TypesEpilogue = testing::Types<
+                                     TEST_GEMM(1U, 1U, 1U),
+                                     TEST_GEMM(4U, 4U, 4U),
+                                     TEST_GEMM(5U, 7U, 3U),
+                                     TEST_GEMM(16U, 16U, 16U),
+                                     TEST_GEMM(13U, 11U, 19U),
+                                     TEST_GEMM(67U, 300U, 45U),
+                                     // Test several macro blocks of the driver
+                                     TEST_GEMM(131U, 517U, 519U)>;
+
+TYPED_TEST_CASE(Epilogue, TypesEpilogue);
+
+static const struct {
+    const char *name;
+    EpilogueFunc func;
+} kEpilogueFuncs[] = {
+    {"gemm_block4x4_ref_epilogue", gemm_block4x4_ref_epilogue},
+    {"gemm_block4x4_rvv_epilogue", gemm_block4x4_rvv_epilogue},
+    {"gemm_block4x4_rvm_epilogue", gemm_block4x4_rvm_epilogue},
+};
+
+TYPED_TEST(Epilogue, Bias_Activation)
+{
+    for (const auto &f : kEpilogueFuncs) {
+        for (const gemm_activation_t activation : {GEMM_ACTIVATION_NONE, GEMM_ACTIVATION_RELU, GEMM_ACTIVATION_GELU}) {
+            for (const bool rowBias : {false, true}) {
+                for (const bool colBias : {false, true}) {
+                    ASSERT_TRUE(TestFixture::Check(f.func, 1.0f, 1.0f, rowBias, colBias, activation))
+                        << f.name << " activation = " << activation << " row_bias = " << rowBias
+                        << " col_bias = " << colBias;
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(Epilogue, Alpha_Beta)
+{
+    const float factors[][2] = {{1.0f, 0.0f}, {0.5f, 2.5f}, {0.0f, 2.5f}, {0.0f, 0.0f}};
+
+    for (const auto &f : kEpilogueFuncs) {
+        for (const auto &factor : factors) {
+            ASSERT_TRUE(TestFixture::Check(f.func, factor[0], factor[1], true, true, GEMM_ACTIVATION_RELU))
+                << f.name << " alpha = " << factor[0] << " beta = " << factor[1];
+        }
+    }
+}
+
+TYPED_TEST(Epilogue, Threads)
+{
+    const size_t parallel_threshold = gemm_get_parallel_threshold();
+    gemm_set_parallel_threshold(0);
+    for (const size_t threads : {2U, 3U}) {
+        gemm_set_num_threads(threads);
+        for (const auto &f : kEpilogueFuncs) {
+            ASSERT_TRUE(TestFixture::Check(f.func, 1.0f, 1.0f, true, true, GEMM_ACTIVATION_GELU))
+                << f.name << " threads = " << threads;
+        }
+    }
+    gemm_set_num_threads(0);
+    gemm_set_parallel_threshold(parallel_threshold);
+}
+
+TEST(Epilogue, Null)
+{
+    const float A[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    const float B[] = {5.0f, 6.0f, 7.0f, 8.0f};
+    float C[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    const float C_ref[] = {20.0f, 23.0f, 44.0f, 51.0f};
+
+    gemm_block4x4_rvm_epilogue(A, B, C, 2, 2, 2, nullptr);
+    ASSERT_TRUE(AssertMatricesEqual(C_ref, C, 2, 2));
+}
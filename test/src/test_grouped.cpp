@@ -0,0 +1,65 @@
+#include "test_common.hpp"
+
+#include <array>
+
+/**
+ * Runs gemm_grouped for the given shapes and compares every product with gemm_ref.
+ */
+static void CheckGrouped(const std::vector<std::array<size_t, 3>> &shapes)
+{
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<float> dist(0, 100);
+
+    const size_t count = shapes.size();
+    std::vector<std::vector<float>> A(count), B(count), C_ref(count), C_comp(count);
+    std::vector<gemm_problem_t> problems(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t n = shapes[i][0];
+        const size_t m = shapes[i][1];
+        const size_t k = shapes[i][2];
+        A[i].resize(n*m);
+        B[i].resize(m*k);
+        C_ref[i].resize(n*k);
+        std::generate(A[i].begin(), A[i].end(), [&] { return dist(rng); });
+        std::generate(B[i].begin(), B[i].end(), [&] { return dist(rng); });
+        std::generate(C_ref[i].begin(), C_ref[i].end(), [&] { return dist(rng); });
+        C_comp[i] = C_ref[i];
+
+        gemm_ref(A[i].data(), B[i].data(), C_ref[i].data(), n, m, k);
+        problems[i] = {n, m, k, A[i].data(), B[i].data(), C_comp[i].data()};
+    }
+
+    gemm_grouped(problems.data(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const auto threshold = std::numeric_limits<float>::epsilon() * shapes[i][1] * 2;
+        ASSERT_TRUE(AssertMatricesEqual(C_ref[i].data(), C_comp[i].data(), shapes[i][0], shapes[i][2], threshold))
+            << "problem " << i;
+    }
+}
+
+TEST(GemmGrouped, SingleProblem) {
+    CheckGrouped({{13, 11, 19}});
+}
+
+TEST(GemmGrouped, Experts_SharedMK) {
+    // Different number of rows per expert, the same weights shape
+    CheckGrouped({{1, 96, 80}, {37, 96, 80}, {300, 96, 80}, {5, 96, 80}, {0, 96, 80}, {129, 96, 80}});
+}
+
+TEST(GemmGrouped, DifferentShapes) {
+    CheckGrouped({{7, 5, 1}, {1, 1, 1}, {131, 517, 519}, {4, 4, 4}, {21, 9, 35}, {3, 0, 3}, {300, 40, 600}});
+}
+
+TEST(GemmGrouped, DifferentShapes_Threads) {
+    const size_t parallel_threshold = gemm_get_parallel_threshold();
+    gemm_set_parallel_threshold(0);
+    for (const size_t threads : {1U, 2U, 3U, 4U}) {
+        gemm_set_num_threads(threads);
+        CheckGrouped({{7, 5, 1}, {1, 1, 1}, {131, 517, 519}, {4, 4, 4}, {21, 9, 35}, {3, 0, 3}, {300, 40, 600}});
+    }
+    gemm_set_num_threads(0);
+    gemm_set_parallel_threshold(parallel_threshold);
+}
@@ -0,0 +1,141 @@
+#include "test_common.hpp"
+
+#include <cstring>
+
+/**
+ * Statistics of an entry point and shape, nullptr if the shape was not counted.
+ */
+static const gemm_perf_entry_t *FindEntry(const std::vector<gemm_perf_entry_t> &entries, const char *entry,
+                                          size_t n, size_t m, size_t k)
+{
+    for (const auto &e : entries) {
+        if ((std::strcmp(e.entry, entry) == 0) && (e.n == n) && (e.m == m) && (e.k == k)) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+static std::vector<gemm_perf_entry_t> GetStats()
+{
+    std::vector<gemm_perf_entry_t> entries(gemm_perf_get_stats(nullptr, 0));
+    entries.resize(gemm_perf_get_stats(entries.data(), entries.size()));
+    return entries;
+}
+
+class GemmPerf : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        threshold = gemm_get_parallel_threshold();
+        gemm_perf_reset();
+    }
+
+    void TearDown() override
+    {
+        gemm_set_num_threads(0);
+        gemm_set_parallel_threshold(threshold);
+        gemm_perf_reset();
+    }
+
+    size_t threshold = 0;
+};
+
+TEST_F(GemmPerf, CallsAndFlopsPerShape)
+{
+    std::vector<float> A(13 * 11, 1.0f);
+    std::vector<float> B(11 * 19, 1.0f);
+    std::vector<float> C(13 * 19, 0.0f);
+    for (int i = 0; i < 3; i++) {
+        gemm_block4x4_ref(A.data(), B.data(), C.data(), 5, 7, 3);
+    }
+    gemm_block4x4_ref(A.data(), B.data(), C.data(), 13, 11, 19);
+    gemm_block4x4_rvm(A.data(), B.data(), C.data(), 5, 7, 3);
+
+    const auto entries = GetStats();
+    ASSERT_EQ(entries.size(), 3U);
+
+    const gemm_perf_entry_t *small = FindEntry(entries, "gemm_block4x4_ref", 5, 7, 3);
+    ASSERT_NE(small, nullptr);
+    EXPECT_EQ(small->calls, 3U);
+    EXPECT_EQ(small->flops, 3U * 2 * 5 * 7 * 3);
+
+    const gemm_perf_entry_t *large = FindEntry(entries, "gemm_block4x4_ref", 13, 11, 19);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(large->calls, 1U);
+    EXPECT_EQ(large->flops, 2U * 13 * 11 * 19);
+
+    const gemm_perf_entry_t *rvm = FindEntry(entries, "gemm_block4x4_rvm", 5, 7, 3);
+    ASSERT_NE(rvm, nullptr);
+    EXPECT_EQ(rvm->calls, 1U);
+    EXPECT_EQ(rvm->flops, 2U * 5 * 7 * 3);
+}
+
+TEST_F(GemmPerf, BatchedAndGroupedFlops)
+{
+    const size_t n = 4;
+    const size_t m = 5;
+    const size_t k = 6;
+    const size_t batch = 7;
+    std::vector<float> A(n*m * batch, 1.0f);
+    std::vector<float> B(m*k * batch, 1.0f);
+    std::vector<float> C(n*k * batch, 0.0f);
+    gemm_strided_batched(A.data(), n*m, B.data(), m*k, C.data(), n*k, n, m, k, batch);
+
+    const gemm_problem_t problems[] = {
+        {4, 5, 6, A.data(), B.data(), C.data()},
+        {2, 3, 1, A.data(), B.data(), C.data()},
+    };
+    gemm_grouped(problems, 2);
+
+    const auto entries = GetStats();
+    ASSERT_EQ(entries.size(), 2U);
+
+    // Batched calls are recorded with the shape of their products and the work of all of them
+    const gemm_perf_entry_t *batched = FindEntry(entries, "gemm_strided_batched", n, m, k);
+    ASSERT_NE(batched, nullptr);
+    EXPECT_EQ(batched->calls, 1U);
+    EXPECT_EQ(batched->flops, 2U * n * m * k * batch);
+
+    const gemm_perf_entry_t *grouped = FindEntry(entries, "gemm_grouped", 0, 0, 0);
+    ASSERT_NE(grouped, nullptr);
+    EXPECT_EQ(grouped->calls, 1U);
+    EXPECT_EQ(grouped->flops, 2U * ((4 * 5 * 6) + (2 * 3 * 1)));
+}
+
+TEST_F(GemmPerf, ParallelCalls)
+{
+    // Products split between the pool workers are recorded once, with the work of the whole product
+    gemm_set_num_threads(4);
+    gemm_set_parallel_threshold(0);
+
+    const size_t size = 96;
+    std::vector<float> A(size * size, 1.0f);
+    std::vector<float> B(size * size, 1.0f);
+    std::vector<float> C(size * size, 0.0f);
+    for (int i = 0; i < 2; i++) {
+        gemm_block4x4_ref(A.data(), B.data(), C.data(), size, size, size);
+    }
+    for (const float c : C) {
+        ASSERT_EQ(c, 2.0f * size);
+    }
+
+    const auto entries = GetStats();
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].calls, 2U);
+    EXPECT_EQ(entries[0].flops, 2U * 2 * size * size * size);
+    ASSERT_EQ(gemm_perf_dump(stdout), 0);
+}
+
+TEST_F(GemmPerf, Reset)
+{
+    std::vector<float> A(16, 1.0f);
+    std::vector<float> B(16, 1.0f);
+    std::vector<float> C(16, 0.0f);
+    gemm_block4x4_ref(A.data(), B.data(), C.data(), 4, 4, 4);
+    ASSERT_EQ(gemm_perf_get_stats(nullptr, 0), 1U);
+
+    gemm_perf_reset();
+    ASSERT_EQ(gemm_perf_get_stats(nullptr, 0), 0U);
+}
@@ -16,7 +16,7 @@ public:
     using VectorType = std::vector<ElemType>;
 };
 
-TEST(GemmRefSquare, DISABLED_SimpleTets_1x1) {
+TEST(GemmRefSquare, SimpleTets_1x1) {
     const size_t rows = 1;
     const size_t cols = 1;
     const float A[] = {1.0f};
@@ -30,7 +30,7 @@ TEST(GemmRefSquare, DISABLED_SimpleTets_1x1) {
     ASSERT_TRUE(AssertMatricesEqual(C_ref, C_comp, rows, cols, std::numeric_limits<float>::epsilon()));
 }
 
-TEST(GemmRefSquare, DISABLED_SimpleTets_2x2) {
+TEST(GemmRefSquare, SimpleTets_2x2) {
     const size_t rows = 2;
     const size_t cols = 2;
     const float A[] = {1.0f, 2.0f,
@@ -46,7 +46,7 @@ TEST(GemmRefSquare, DISABLED_SimpleTets_2x2) {
     ASSERT_TRUE(AssertMatricesEqual(C_ref, C_comp, rows, cols, std::numeric_limits<float>::epsilon()));
 }
 
-TEST(GemmRefSquare, DISABLED_SimpleTets_3x3) {
+TEST(GemmRefSquare, SimpleTets_3x3) {
     const size_t rows = 3;
     const size_t cols = 3;
     const float A[] = {1.0f, 2.0f, 3.0f,
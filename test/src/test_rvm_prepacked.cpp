@@ -0,0 +1,110 @@
+#include "test_common.hpp"
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+
+template <typename T>
+class GemmRVMPrepacked : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+};
+
+#define TEST_GEMM(n, m, k) \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>, std::integral_constant<size_t, (k)>>
+
+using TypesPrepacked = testing::Types<
+                                      TEST_GEMM(1U, 1U, 1U),
+                                      TEST_GEMM(4U, 4U, 4U),
+                                      TEST_GEMM(5U, 7U, 3U),
+                                      TEST_GEMM(16U, 16U, 16U),
+                                      TEST_GEMM(13U, 11U, 19U),
+                                      TEST_GEMM(127U, 31U, 1001U),
+                                      // Test several macro blocks of the driver
+                                      TEST_GEMM(131U, 517U, 519U)>;
+
+TYPED_TEST_CASE(GemmRVMPrepacked, TypesPrepacked);
+
+TYPED_TEST(GemmRVMPrepacked, Rand_ABC_ReuseB)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    VectorType A(n*m, 0.0f);
+    VectorType B(m*k, 0.0f);
+    VectorType C_ref(n*k, 0.0f);
+    VectorType C_comp(n*k, 0.0f);
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+
+    gemm_packed_b *packedB = gemm_pack_b(B.data(), m, k);
+    ASSERT_NE(packedB, nullptr);
+
+    // The same packed B is used for several matrices A
+    for (size_t iter = 0; iter < 3; iter++) {
+        std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+        std::generate(C_ref.begin(), C_ref.end(), [&] { return dist(rng); });
+        std::copy(C_ref.begin(), C_ref.end(), C_comp.begin());
+
+        gemm_ref(A.data(), B.data(), C_ref.data(), n, m, k);
+        gemm_rvm_prepacked(A.data(), packedB, C_comp.data(), n);
+
+        ASSERT_TRUE(AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold));
+    }
+
+    gemm_packed_b_free(packedB);
+}
+
+TYPED_TEST(GemmRVMPrepacked, Rand_ABC_UserBuffer)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    VectorType A(n*m, 0.0f);
+    VectorType B(m*k, 0.0f);
+    VectorType C_ref(n*k, 0.0f);
+    VectorType C_comp(n*k, 0.0f);
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    std::generate(C_ref.begin(), C_ref.end(), [&] { return dist(rng); });
+    std::copy(C_ref.begin(), C_ref.end(), C_comp.begin());
+
+    // Unaligned buffer placed by the caller
+    std::vector<char> buffer(gemm_packed_b_size(m, k) + 1);
+    gemm_packed_b *packedB = gemm_pack_b_to(B.data(), m, k, buffer.data() + 1);
+    ASSERT_NE(packedB, nullptr);
+
+    gemm_ref(A.data(), B.data(), C_ref.data(), n, m, k);
+    gemm_rvm_prepacked(A.data(), packedB, C_comp.data(), n);
+
+    ASSERT_TRUE(AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold));
+
+    gemm_packed_b_free(packedB);
+}
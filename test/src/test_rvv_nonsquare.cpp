@@ -164,7 +164,9 @@ using TypesNonSqare = testing::Types<
                                      TEST_GEMM(7U, 5U, 5U),
                                      TEST_GEMM(5U, 5U, 5U),
                                      TEST_GEMM(5U, 6U, 5U),
-                                     TEST_GEMM(5U, 7U, 5U)>;
+                                     TEST_GEMM(5U, 7U, 5U),
+                                     // Test several macro blocks of the driver
+                                     TEST_GEMM(131U, 517U, 519U)>;
 
 TYPED_TEST_CASE(GemmRVVNonSqare, TypesNonSqare);
 
@@ -249,3 +251,38 @@ TYPED_TEST(GemmRVVNonSqare, Rand_ABC)
 
     ASSERT_TRUE(AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold));
 }
+
+TYPED_TEST(GemmRVVNonSqare, Rand_ABC_AllLmul)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+
+    const auto threshold = std::numeric_limits<ElemType>::epsilon() * m * 2;
+
+    VectorType A(n*m, 0.0f);
+    VectorType B(m*k, 0.0f);
+    VectorType C_init(n*k, 0.0f);
+    VectorType C_ref(n*k, 0.0f);
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(0, 100);
+
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    std::generate(C_init.begin(), C_init.end(), [&] { return dist(rng); });
+    std::copy(C_init.begin(), C_init.end(), C_ref.begin());
+
+    gemm_ref(A.data(), B.data(), C_ref.data(), n, m, k);
+
+    for (auto gemm : {gemm_block4x4_rvv_m1, gemm_block4x4_rvv_m2, gemm_block4x4_rvv_m4, gemm_block4x4_rvv_m8}) {
+        VectorType C_comp(C_init);
+        gemm(A.data(), B.data(), C_comp.data(), n, m, k);
+
+        ASSERT_TRUE(AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold));
+    }
+}
@@ -0,0 +1,207 @@
+#include "test_common.hpp"
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+
+// Padding added to the leading dimensions, so the matrices are submatrices of larger ones
+constexpr size_t ldPadding{3U};
+
+using SgemmFunc = int (*)(const gemm_layout_t, const gemm_transpose_t, const gemm_transpose_t,
+                          const size_t, const size_t, const size_t, const float,
+                          const float *, const size_t, const float *, const size_t,
+                          const float, float *, const size_t);
+
+template <typename T>
+class Sgemm : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+
+    /**
+     * Checks C = alpha * op(A) * op(B) + beta * C of func against gemm_ref on explicitly transposed copies.
+     * M = n, N = k, K = m in the notation of gemm_ref.
+     */
+    static ::testing::AssertionResult Check(SgemmFunc func, gemm_layout_t layout, gemm_transpose_t transA,
+                                            gemm_transpose_t transB, ElemType alpha, ElemType beta)
+    {
+        std::mt19937 rng;
+        rng.seed(std::random_device()());
+        std::uniform_real_distribution<ElemType> dist(0, 100);
+
+        // op(A) is n x m, op(B) is m x k, C is n x k, all row-major
+        VectorType opA(n*m, 0.0f);
+        VectorType opB(m*k, 0.0f);
+        VectorType C_init(n*k, 0.0f);
+        std::generate(opA.begin(), opA.end(), [&] { return dist(rng); });
+        std::generate(opB.begin(), opB.end(), [&] { return dist(rng); });
+        std::generate(C_init.begin(), C_init.end(), [&] { return dist(rng); });
+
+        VectorType product(n*k, 0.0f);
+        gemm_ref(opA.data(), opB.data(), product.data(), n, m, k);
+        VectorType C_ref(n*k, 0.0f);
+        for (size_t i = 0; i < n*k; i++) {
+            C_ref[i] = alpha * product[i] + ((beta == 0.0f) ? 0.0f : beta * C_init[i]);
+        }
+
+        // Stored matrices: element (r, c) of a matrix with `rows` x `cols` elements is at
+        // r * ld + c for row-major and c * ld + r for column-major storage.
+        const bool rowMajor = (layout == GEMM_ROW_MAJOR);
+        auto store = [&](const VectorType &src, size_t rows, size_t cols, bool trans, size_t &ld) {
+            const size_t storedRows = trans ? cols : rows;
+            const size_t storedCols = trans ? rows : cols;
+            ld = (rowMajor ? storedCols : storedRows) + ldPadding;
+            VectorType dst(ld * (rowMajor ? storedRows : storedCols), -1.0f);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    const size_t sr = trans ? c : r;
+                    const size_t sc = trans ? r : c;
+                    dst[rowMajor ? (sr * ld + sc) : (sc * ld + sr)] = src[r * cols + c];
+                }
+            }
+            return dst;
+        };
+
+        size_t lda = 0;
+        size_t ldb = 0;
+        size_t ldc = 0;
+        const VectorType A = store(opA, n, m, transA == GEMM_TRANS, lda);
+        const VectorType B = store(opB, m, k, transB == GEMM_TRANS, ldb);
+        VectorType C = store(C_init, n, k, false, ldc);
+        if (beta == 0.0f) {
+            // C must not be read
+            std::fill(C.begin(), C.end(), std::numeric_limits<ElemType>::quiet_NaN());
+        }
+
+        const int info = func(layout, transA, transB, n, k, m, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+        if (info != 0) {
+            return ::testing::AssertionFailure() << "Parameter " << info << " is reported as invalid";
+        }
+
+        VectorType C_comp(n*k, 0.0f);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < k; j++) {
+                C_comp[i * k + j] = C[rowMajor ? (i * ldc + j) : (j * ldc + i)];
+            }
+        }
+
+        const auto threshold = std::numeric_limits<ElemType>::epsilon() * (m + 2) * 2;
+        return AssertMatricesEqual(C_ref.data(), C_comp.data(), n, k, threshold);
+    }
+};
+
+#define TEST_GEMM(n, m, k) \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>, std::integral_constant<size_t, (k)>>
+
+using TypesSgemm = testing::Types<
+                                  TEST_GEMM(1U, 1U, 1U),
+                                  TEST_GEMM(4U, 4U, 4U),
+                                  TEST_GEMM(5U, 7U, 3U),
+                                  TEST_GEMM(16U, 16U, 16U),
+                                  TEST_GEMM(13U, 11U, 19U),
+                                  TEST_GEMM(67U, 300U, 45U),
+                                  // Test several macro blocks of the driver
+                                  TEST_GEMM(131U, 517U, 519U)>;
+
+TYPED_TEST_CASE(Sgemm, TypesSgemm);
+
+static const struct {
+    const char *name;
+    SgemmFunc func;
+} kSgemmFuncs[] = {
+    {"sgemm_ref", sgemm_ref},
+    {"sgemm_rvv", sgemm_rvv},
+    {"sgemm_rvm", sgemm_rvm},
+    {"sgemm", sgemm},
+};
+
+TYPED_TEST(Sgemm, Layouts_Transposes)
+{
+    for (const auto &f : kSgemmFuncs) {
+        for (const gemm_layout_t layout : {GEMM_ROW_MAJOR, GEMM_COL_MAJOR}) {
+            for (const gemm_transpose_t transA : {GEMM_NO_TRANS, GEMM_TRANS}) {
+                for (const gemm_transpose_t transB : {GEMM_NO_TRANS, GEMM_TRANS}) {
+                    ASSERT_TRUE(TestFixture::Check(f.func, layout, transA, transB, 1.0f, 1.0f))
+                        << f.name << " layout = " << layout << " transA = " << transA << " transB = " << transB;
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(Sgemm, Alpha_Beta)
+{
+    const float factors[][2] = {{1.0f, 0.0f}, {0.5f, 0.0f}, {0.5f, 2.5f}, {0.0f, 2.5f}, {2.0f, 1.0f}};
+
+    for (const auto &f : kSgemmFuncs) {
+        for (const auto &factor : factors) {
+            ASSERT_TRUE(TestFixture::Check(f.func, GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_TRANS, factor[0], factor[1]))
+                << f.name << " alpha = " << factor[0] << " beta = " << factor[1];
+            ASSERT_TRUE(TestFixture::Check(f.func, GEMM_COL_MAJOR, GEMM_TRANS, GEMM_NO_TRANS, factor[0], factor[1]))
+                << f.name << " alpha = " << factor[0] << " beta = " << factor[1];
+        }
+    }
+}
+
+TEST(SgemmParameters, Invalid)
+{
+    // 5 x 7 times 7 x 3, stored without padding
+    const size_t M = 5;
+    const size_t N = 3;
+    const size_t K = 7;
+    const std::vector<float> A(M * K, 1.0f);
+    const std::vector<float> B(K * N, 1.0f);
+    const auto badLayout = static_cast<gemm_layout_t>(0);
+    const auto badTrans = static_cast<gemm_transpose_t>(0);
+
+    const struct {
+        gemm_layout_t layout;
+        gemm_transpose_t transA;
+        gemm_transpose_t transB;
+        size_t lda;
+        size_t ldb;
+        size_t ldc;
+        int info;
+    } cases[] = {
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, K, N, N, 0},
+        {GEMM_COL_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, M, K, M, 0},
+        {GEMM_ROW_MAJOR, GEMM_TRANS, GEMM_TRANS, M, K, N, 0},
+        {GEMM_COL_MAJOR, GEMM_TRANS, GEMM_TRANS, K, N, M, 0},
+        {badLayout, GEMM_NO_TRANS, GEMM_NO_TRANS, K, N, N, 1},
+        {GEMM_ROW_MAJOR, badTrans, GEMM_NO_TRANS, K, N, N, 2},
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, badTrans, K, N, N, 3},
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, K - 1, N, N, 9},
+        {GEMM_ROW_MAJOR, GEMM_TRANS, GEMM_NO_TRANS, M - 1, N, N, 9},
+        {GEMM_COL_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, M - 1, K, M, 9},
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, K, N - 1, N, 11},
+        {GEMM_COL_MAJOR, GEMM_NO_TRANS, GEMM_TRANS, M, N - 1, M, 11},
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, K, N, N - 1, 14},
+        {GEMM_COL_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, M, K, M - 1, 14},
+        // The first invalid parameter is reported
+        {GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, K - 1, N - 1, N - 1, 9},
+    };
+
+    for (const auto &f : kSgemmFuncs) {
+        for (const auto &c : cases) {
+            // C is large enough for every leading dimension and is not touched by an invalid call
+            std::vector<float> C(M * M, 0.0f);
+            const int info = f.func(c.layout, c.transA, c.transB, M, N, K, 1.0f, A.data(), c.lda, B.data(), c.ldb,
+                                    0.0f, C.data(), c.ldc);
+            EXPECT_EQ(info, c.info) << f.name << " lda = " << c.lda << " ldb = " << c.ldb << " ldc = " << c.ldc;
+            if (c.info != 0) {
+                EXPECT_TRUE(std::all_of(C.begin(), C.end(), [](float x) { return x == 0.0f; })) << f.name;
+            }
+        }
+    }
+
+    // Leading dimensions of empty matrices must still be at least 1
+    for (const auto &f : kSgemmFuncs) {
+        EXPECT_EQ(f.func(GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, 0, 0, 0, 1.0f, nullptr, 0, nullptr, 1, 0.0f,
+                         nullptr, 1), 9) << f.name;
+    }
+}
@@ -0,0 +1,161 @@
+#include "test_common.hpp"
+
+constexpr size_t nIndex{0U};
+constexpr size_t mIndex{1U};
+constexpr size_t kIndex{2U};
+constexpr size_t crossoverIndex{3U};
+
+template <typename T>
+class GemmStrassen : public ::testing::Test
+{
+public:
+    static constexpr size_t n = std::tuple_element_t<nIndex, T>{};
+    static constexpr size_t m = std::tuple_element_t<mIndex, T>{};
+    static constexpr size_t k = std::tuple_element_t<kIndex, T>{};
+    static constexpr size_t crossover = std::tuple_element_t<crossoverIndex, T>{};
+
+    using ElemType = float;
+    using VectorType = std::vector<ElemType>;
+};
+
+#define TEST_GEMM(n, m, k, crossover) \
+    std::tuple<std::integral_constant<size_t, (n)>, std::integral_constant<size_t, (m)>, \
+               std::integral_constant<size_t, (k)>, std::integral_constant<size_t, (crossover)>>
+
+using TypesStrassen = testing::Types<
+                                     // Not split, computed by the kernel
+                                     TEST_GEMM(5U, 7U, 3U, 0U),
+                                     TEST_GEMM(64U, 64U, 64U, 64U),
+                                     // One and several levels
+                                     TEST_GEMM(64U, 64U, 64U, 32U),
+                                     TEST_GEMM(256U, 256U, 256U, 32U),
+                                     TEST_GEMM(128U, 128U, 128U, 8U),
+                                     // Odd rows and columns are peeled on every level
+                                     TEST_GEMM(67U, 73U, 71U, 8U),
+                                     TEST_GEMM(131U, 517U, 519U, 32U),
+                                     TEST_GEMM(200U, 40U, 300U, 16U)>;
+
+TYPED_TEST_CASE(GemmStrassen, TypesStrassen);
+
+/**
+ * Bound of the error of gemm_strassen documented in gemm.h for max |A| max |B| = 1 plus the error of
+ * the classical product the result is compared with.
+ */
+static double ErrorBound(size_t n, size_t m, size_t k, size_t crossover)
+{
+    const double u = std::numeric_limits<float>::epsilon() / 2;
+    crossover = (crossover == 0) ? GEMM_STRASSEN_CROSSOVER : std::max<size_t>(crossover, 8);
+
+    double size = static_cast<double>(std::max(n, std::max(m, k)));
+    double levels = 0;
+    while (std::min(n, std::min(m, k)) > crossover) {
+        n = (n / 8) * 4;
+        m = (m / 8) * 4;
+        k = (k / 8) * 4;
+        levels++;
+    }
+    const double leaf = size / std::pow(2.0, levels);
+    const double strassen = (std::pow(18.0, levels) * ((leaf * leaf) + (6 * leaf))) - (6 * size);
+    return (std::max(strassen, leaf) + size) * u;
+}
+
+static float MaxAbs(const std::vector<float> &X)
+{
+    float result = 0.0f;
+    for (const float x : X) {
+        result = std::max(result, std::abs(x));
+    }
+    return result;
+}
+
+static ::testing::AssertionResult AssertErrorBounded(const std::vector<float> &expected, const std::vector<float> &actual,
+                                                     double bound)
+{
+    for (size_t i = 0; i < expected.size(); i++) {
+        const double error = std::abs(static_cast<double>(expected[i]) - actual[i]);
+        if (!(error <= bound)) {
+            return ::testing::AssertionFailure() << "Error at " << i << " is " << error << ", which exceeds the bound "
+                                                 << bound << ". Expected: " << expected[i] << ", Actual: " << actual[i];
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
+TYPED_TEST(GemmStrassen, Rand_ABC)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+    const size_t crossover = TestFixture::crossover;
+
+    VectorType A(n*m, 0.0f);
+    VectorType B(m*k, 0.0f);
+    VectorType C_ref(n*k, 0.0f);
+    VectorType C_comp(n*k, 0.0f);
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(-100, 100);
+
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+    std::generate(C_ref.begin(), C_ref.end(), [&] { return dist(rng); });
+    std::copy(C_ref.begin(), C_ref.end(), C_comp.begin());
+
+    gemm_ref(A.data(), B.data(), C_ref.data(), n, m, k);
+    ASSERT_EQ(gemm_strassen(A.data(), B.data(), C_comp.data(), n, m, k, crossover, nullptr), 0);
+
+    const double bound = (ErrorBound(n, m, k, crossover) * MaxAbs(A) * MaxAbs(B)) +
+                         (std::numeric_limits<ElemType>::epsilon() * MaxAbs(C_ref));
+    ASSERT_TRUE(AssertErrorBounded(C_ref, C_comp, bound));
+}
+
+TYPED_TEST(GemmStrassen, Rand_ABC_UserWorkspace)
+{
+    using ElemType   = typename TestFixture::ElemType;
+    using VectorType = typename TestFixture::VectorType;
+
+    const size_t n = TestFixture::n;
+    const size_t m = TestFixture::m;
+    const size_t k = TestFixture::k;
+    const size_t crossover = TestFixture::crossover;
+
+    VectorType A(n*m, 0.0f);
+    VectorType B(m*k, 0.0f);
+    VectorType C_alloc(n*k, 0.0f);
+    VectorType C_comp(n*k, 0.0f);
+
+    std::mt19937 rng;
+    rng.seed(std::random_device()());
+    std::uniform_real_distribution<ElemType> dist(-100, 100);
+
+    std::generate(A.begin(), A.end(), [&] { return dist(rng); });
+    std::generate(B.begin(), B.end(), [&] { return dist(rng); });
+
+    // The workspace is reused and its contents do not matter
+    const size_t size = gemm_strassen_workspace_size(n, m, k, crossover);
+    VectorType workspace(size / sizeof(ElemType) + 1, std::numeric_limits<ElemType>::quiet_NaN());
+    for (size_t iter = 0; iter < 2; iter++) {
+        std::fill(C_comp.begin(), C_comp.end(), 0.0f);
+        ASSERT_EQ(gemm_strassen(A.data(), B.data(), C_comp.data(), n, m, k, crossover, workspace.data()), 0);
+    }
+    ASSERT_EQ(gemm_strassen(A.data(), B.data(), C_alloc.data(), n, m, k, crossover, nullptr), 0);
+
+    // The same operations in the same order give the same result
+    ASSERT_TRUE(AssertErrorBounded(C_alloc, C_comp, 0.0));
+}
+
+TEST(GemmStrassenWorkspace, Size)
+{
+    // Products not split need no workspace
+    ASSERT_EQ(gemm_strassen_workspace_size(64, 64, 64, 64), 0U);
+    ASSERT_EQ(gemm_strassen_workspace_size(1024, 1024, 8, 0), 0U);
+
+    // S, T and P of every level
+    ASSERT_EQ(gemm_strassen_workspace_size(64, 64, 64, 32), 3U * 32 * 32 * sizeof(float));
+    ASSERT_EQ(gemm_strassen_workspace_size(64, 64, 64, 16), 3U * (32 * 32 + 16 * 16) * sizeof(float));
+    ASSERT_EQ(gemm_strassen_workspace_size(24, 40, 56, 12), (12U * 20 + 20 * 28 + 12 * 28) * sizeof(float));
+}
@@ -0,0 +1,187 @@
+#include "test_common.hpp"
+
+#include <string>
+#include <thread>
+
+/**
+ * Operands of a product with the given shape.
+ */
+struct Operands {
+    std::vector<float> A;
+    std::vector<float> B;
+    std::vector<float> C;
+
+    Operands(size_t n, size_t m, size_t k) : A(n*m, 1.0f), B(m*k, 1.0f), C(n*k, 0.0f) {}
+};
+
+static uint64_t TotalCalls(const gemm_trace_stats_t &stats)
+{
+    uint64_t calls = 0;
+    for (size_t b = 0; b < GEMM_BACKEND_COUNT; b++) {
+        calls += stats.calls[b];
+    }
+    return calls;
+}
+
+class GemmTrace : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        gemm_trace_reset();
+        gemm_trace_enable(1);
+    }
+
+    void TearDown() override
+    {
+        gemm_trace_enable(0);
+        gemm_trace_set_callback(nullptr, nullptr);
+        gemm_trace_reset();
+    }
+};
+
+TEST_F(GemmTrace, Disabled)
+{
+    gemm_trace_enable(0);
+    Operands op(8, 8, 8);
+    gemm_block4x4_ref(op.A.data(), op.B.data(), op.C.data(), 8, 8, 8);
+
+    gemm_trace_stats_t stats;
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(TotalCalls(stats), 0U);
+    ASSERT_EQ(gemm_trace_get_shapes(nullptr, 0), 0U);
+}
+
+TEST_F(GemmTrace, StatsPerBackend)
+{
+    Operands small(4, 5, 6);
+    Operands large(32, 16, 8);
+    for (int i = 0; i < 3; i++) {
+        gemm_block4x4_ref(small.A.data(), small.B.data(), small.C.data(), 4, 5, 6);
+    }
+    gemm_ref(large.A.data(), large.B.data(), large.C.data(), 32, 16, 8);
+
+    gemm_trace_stats_t stats;
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(stats.calls[GEMM_BACKEND_REF], 4U);
+    ASSERT_EQ(stats.flops[GEMM_BACKEND_REF], 3U * 2 * 4 * 5 * 6 + 2 * 32 * 16 * 8);
+    ASSERT_EQ(stats.untracked, 0U);
+
+    gemm_trace_reset();
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(TotalCalls(stats), 0U);
+}
+
+TEST_F(GemmTrace, ShapeHistogram)
+{
+    Operands small(4, 4, 4);
+    Operands large(64, 64, 64);
+    for (int i = 0; i < 5; i++) {
+        gemm_block4x4_ref(small.A.data(), small.B.data(), small.C.data(), 4, 4, 4);
+    }
+    gemm_block4x4_ref(large.A.data(), large.B.data(), large.C.data(), 64, 64, 64);
+
+    std::vector<gemm_trace_shape_t> shapes(4);
+    ASSERT_EQ(gemm_trace_get_shapes(shapes.data(), shapes.size()), 2U);
+
+    // Sorted by the total time, the single large product takes longer than the small ones
+    ASSERT_EQ(shapes[0].n, 64U);
+    ASSERT_EQ(shapes[0].calls, 1U);
+    ASSERT_EQ(shapes[1].n, 4U);
+    ASSERT_EQ(shapes[1].calls, 5U);
+    ASSERT_EQ(shapes[1].flops, 5U * 2 * 4 * 4 * 4);
+
+    // A smaller output array receives the first shapes, the count covers all of them
+    ASSERT_EQ(gemm_trace_get_shapes(shapes.data(), 1), 2U);
+    ASSERT_EQ(shapes[0].n, 64U);
+}
+
+TEST_F(GemmTrace, BatchedAndGrouped)
+{
+    constexpr size_t batch = 3;
+    Operands batched(4 * batch, 5, 6);
+    gemm_strided_batched(batched.A.data(), 4 * 5, batched.B.data(), 0, batched.C.data(), 4 * 6, 4, 5, 6, batch);
+
+    Operands small(2, 3, 4);
+    Operands large(16, 8, 8);
+    const gemm_problem_t problems[] = {
+        {2, 3, 4, small.A.data(), small.B.data(), small.C.data()},
+        {16, 8, 8, large.A.data(), large.B.data(), large.C.data()},
+    };
+    gemm_grouped(problems, 2);
+
+    // The totals cover the work of every product
+    gemm_trace_stats_t stats;
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(TotalCalls(stats), 2U);
+    ASSERT_EQ(stats.flops[gemm_get_backend()], batch * 2 * 4 * 5 * 6 + 2 * 2 * 3 * 4 + 2 * 16 * 8 * 8);
+
+    // The histogram holds the shapes of the products
+    std::vector<gemm_trace_shape_t> shapes(4);
+    ASSERT_EQ(gemm_trace_get_shapes(shapes.data(), shapes.size()), 3U);
+    for (size_t i = 0; i < 3; i++) {
+        const gemm_trace_shape_t &shape = shapes[i];
+        ASSERT_EQ(shape.flops, shape.calls * 2 * shape.n * shape.m * shape.k);
+        ASSERT_EQ(shape.calls, (shape.n == 4) ? batch : 1U);
+    }
+}
+
+TEST_F(GemmTrace, Threads)
+{
+    constexpr size_t threadCount = 4;
+    constexpr size_t calls = 10;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([] {
+            Operands op(8, 8, 8);
+            for (size_t i = 0; i < calls; i++) {
+                gemm_block4x4_ref(op.A.data(), op.B.data(), op.C.data(), 8, 8, 8);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Counters of finished threads are kept
+    gemm_trace_stats_t stats;
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(stats.calls[GEMM_BACKEND_REF], threadCount * calls);
+
+    gemm_trace_shape_t shape;
+    ASSERT_EQ(gemm_trace_get_shapes(&shape, 1), 1U);
+    ASSERT_EQ(shape.calls, threadCount * calls);
+}
+
+TEST_F(GemmTrace, Callback)
+{
+    gemm_trace_enable(0);
+    std::vector<gemm_trace_event_t> events;
+    gemm_trace_set_callback([](const gemm_trace_event_t *event, void *user) {
+        static_cast<std::vector<gemm_trace_event_t> *>(user)->push_back(*event);
+    }, &events);
+
+    Operands op(3, 5, 7);
+    gemm_block4x4_ref(op.A.data(), op.B.data(), op.C.data(), 3, 5, 7);
+    gemm(op.A.data(), op.B.data(), op.C.data(), 3, 5, 7);
+
+    ASSERT_EQ(events.size(), 2U);
+    ASSERT_EQ(std::string(events[0].entry), "gemm_block4x4_ref");
+    ASSERT_EQ(events[0].backend, GEMM_BACKEND_REF);
+    ASSERT_EQ(events[0].n, 3U);
+    ASSERT_EQ(events[0].m, 5U);
+    ASSERT_EQ(events[0].k, 7U);
+    ASSERT_EQ(events[0].batch, 1U);
+    ASSERT_EQ(events[0].flops, 2U * 3 * 5 * 7);
+    ASSERT_EQ(std::string(events[1].entry), "gemm");
+    ASSERT_EQ(events[1].backend, gemm_get_backend());
+
+    // The callback does not enable the counters
+    gemm_trace_stats_t stats;
+    gemm_trace_get_stats(&stats);
+    ASSERT_EQ(TotalCalls(stats), 0U);
+
+    gemm_trace_set_callback(nullptr, nullptr);
+    gemm(op.A.data(), op.B.data(), op.C.data(), 3, 5, 7);
+    ASSERT_EQ(events.size(), 2U);
+}